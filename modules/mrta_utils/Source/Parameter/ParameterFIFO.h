@@ -3,6 +3,13 @@
 namespace mrta
 {
 
+// Parameter change event, the index is the parameter position in the ParameterManager
+struct ParameterEvent
+{
+    uint32_t index;
+    float value;
+};
+
 template<size_t Capacity>
 class ParameterFIFO
 {
@@ -18,7 +25,7 @@ public:
         abstractFIFO.reset();
     }
 
-    bool pushParameter(const juce::String& parameterID, float newValue)
+    bool pushParameter(uint32_t index, float newValue)
     {
         if (abstractFIFO.getFreeSpace() == 0)
             return false;
@@ -26,33 +33,39 @@ public:
         auto scope = abstractFIFO.write(1);
 
         if (scope.blockSize1 > 0)
-            buffer[scope.startIndex1] = std::make_pair(parameterID, newValue);
+            buffer[static_cast<size_t>(scope.startIndex1)] = { index, newValue };
 
         if (scope.blockSize2 > 0)
-            buffer[scope.startIndex2] = std::make_pair(parameterID, newValue);
+            buffer[static_cast<size_t>(scope.startIndex2)] = { index, newValue };
 
         return true;
     }
 
-    std::pair<bool, std::pair<juce::String, float>> popParameter()
+    bool popParameter(ParameterEvent& event)
     {
         if (abstractFIFO.getNumReady() == 0)
-            return {};
+            return false;
 
         auto scope = abstractFIFO.read(1);
 
         if (scope.blockSize1 > 0)
-            return { true, buffer[scope.startIndex1] };
+        {
+            event = buffer[static_cast<size_t>(scope.startIndex1)];
+            return true;
+        }
 
         if (scope.blockSize2 > 0)
-            return {true, buffer[scope.startIndex2] };
+        {
+            event = buffer[static_cast<size_t>(scope.startIndex2)];
+            return true;
+        }
 
-        return { false, { "", 0.f } };
+        return false;
     }
 
 private:
     juce::AbstractFifo abstractFIFO;
-    std::array<std::pair<juce::String, float>, Capacity> buffer;
+    std::array<ParameterEvent, Capacity> buffer;
 
     JUCE_DECLARE_NON_COPYABLE(ParameterFIFO)
     JUCE_DECLARE_NON_MOVEABLE(ParameterFIFO)
@@ -49,26 +49,64 @@ juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout(const
     return layout;
 }
 
-ParameterManager::ParameterManager(juce::AudioProcessor& audioProcessor, const juce::String& identifier, const std::vector<mrta::ParameterInfo>& _parameters) :
+static unsigned int countTrailingZeros(uint64_t bits)
+{
+   #if JUCE_MSVC
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned int>(index);
+   #else
+    return static_cast<unsigned int>(__builtin_ctzll(bits));
+   #endif
+}
+
+ParameterManager::ParameterManager(juce::AudioProcessor& audioProcessor, const juce::String& identifier,
+                                   const std::vector<mrta::ParameterInfo>& _parameters, UpdateMode _updateMode) :
     apvts(audioProcessor, nullptr, identifier, createParameterLayout(_parameters)),
-    parameters { _parameters }
+    parameters { _parameters },
+    updateMode { _updateMode },
+    latestValues(parameters.size()),
+    dirtyWords((parameters.size() + BitsPerWord - 1) / BitsPerWord),
+    callbacks(parameters.size()),
+    rawValues(parameters.size(), nullptr),
+    listeners(parameters.size())
 {
+    parameterObjects.reserve(parameters.size());
+    hashToIndex.reserve(parameters.size());
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        rawValues[i] = apvts.getRawParameterValue(parameters[i].ID);
+        latestValues[i].store(parameters[i].def);
+        parameterObjects.push_back(apvts.getParameter(parameters[i].ID));
+        hashToIndex.emplace_back(hashParameterID(parameters[i].ID), static_cast<uint32_t>(i));
+    }
+
+    std::sort(hashToIndex.begin(), hashToIndex.end());
+    jassert(std::adjacent_find(hashToIndex.begin(), hashToIndex.end(),
+                               [] (const auto& a, const auto& b) { return a.first == b.first; }) == hashToIndex.end());
+
+    for (auto& word : dirtyWords)
+        word.store(0);
 }
 
 ParameterManager::~ParameterManager()
 {
-    for (const auto& c : callbacks)
-        apvts.removeParameterListener(c.first, this);
+    for (size_t i = 0; i < listeners.size(); ++i)
+        if (listeners[i])
+            apvts.removeParameterListener(parameters[i].ID, listeners[i].get());
 }
 
 bool ParameterManager::registerParameterCallback(const juce::String& ID, Callback cb)
 {
-    if (ID.isNotEmpty() && cb)
+    const int index { getParameterIndex(ID) };
+    if (index >= 0 && cb)
     {
-        if (callbacks.find(ID) == callbacks.end())
+        const size_t i { static_cast<size_t>(index) };
+        if (!callbacks[i])
         {
-            apvts.addParameterListener(ID, this);
-            callbacks[ID] = cb;
+            callbacks[i] = cb;
+            listeners[i] = std::make_unique<ParameterListener>(*this, static_cast<uint32_t>(i));
+            apvts.addParameterListener(ID, listeners[i].get());
             return true;
         }
     }
@@ -79,27 +117,179 @@ void ParameterManager::updateParameters(bool force)
 {
     if (force)
     {
-        std::for_each(callbacks.begin(), callbacks.end(), [this] (auto& p)
-        {
-            if (auto* raw { apvts.getRawParameterValue(p.first) })
-                p.second(raw->load(), true);
-        });
+        for (size_t i = 0; i < callbacks.size(); ++i)
+            if (callbacks[i] && rawValues[i])
+                callbacks[i](rawValues[i]->load(), true);
         fifo.clear();
+        for (auto& word : dirtyWords)
+            word.store(0, std::memory_order_relaxed);
+    }
+
+    mrta::ParameterEvent event;
+    while (fifo.popParameter(event))
+        callbacks[event.index](event.value, false);
+
+    // Changes that did not fit in the queue, or all of them when coalescing
+    flushDirtyParameters();
+}
+
+void ParameterManager::pushParameter(uint32_t index, float value)
+{
+    latestValues[index].store(value, std::memory_order_relaxed);
+
+    if (updateMode == UpdateMode::Queue && fifo.pushParameter(index, value))
+        return;
+
+    dirtyWords[index / BitsPerWord].fetch_or(uint64_t { 1 } << (index % BitsPerWord), std::memory_order_release);
+}
+
+void ParameterManager::flushDirtyParameters()
+{
+    for (size_t w = 0; w < dirtyWords.size(); ++w)
+    {
+        if (dirtyWords[w].load(std::memory_order_relaxed) == 0)
+            continue;
+
+        uint64_t bits { dirtyWords[w].exchange(0, std::memory_order_acquire) };
+        while (bits != 0)
+        {
+            const size_t index { w * BitsPerWord + countTrailingZeros(bits) };
+            bits &= bits - 1;
+            callbacks[index](latestValues[index].load(std::memory_order_relaxed), false);
+        }
+    }
+}
+
+bool ParameterManager::addTimedParameterChange(const juce::String& ID, float value, int sampleOffset)
+{
+    return addTimedParameterChange(getParameterIndex(ID), value, sampleOffset);
+}
+
+bool ParameterManager::addTimedParameterChange(int index, float value, int sampleOffset)
+{
+    if (index < 0 || static_cast<size_t>(index) >= callbacks.size() || numTimedEvents == MaxTimedEvents)
+        return false;
+
+    sampleOffset = std::max(sampleOffset, 0);
+
+    // Insert after all changes at the same offset so they apply in the order they were added
+    size_t position { numTimedEvents };
+    while (position > 0 && timedEvents[position - 1].sampleOffset > sampleOffset)
+    {
+        timedEvents[position] = timedEvents[position - 1];
+        --position;
     }
 
-    auto newParam = fifo.popParameter();
-    while (newParam.first)
+    timedEvents[position] = { static_cast<uint32_t>(index), value, sampleOffset };
+    ++numTimedEvents;
+    return true;
+}
+
+size_t ParameterManager::applyTimedChanges(size_t first, int sampleOffset)
+{
+    for (; first < numTimedEvents && timedEvents[first].sampleOffset <= sampleOffset; ++first)
+        if (callbacks[timedEvents[first].index])
+            callbacks[timedEvents[first].index](timedEvents[first].value, false);
+    return first;
+}
+
+int ParameterManager::enableSmoothing(const juce::String& ID, float rampTimeSec)
+{
+    const int index { getParameterIndex(ID) };
+    if (index < 0)
+        return -1;
+
+    const float value { rawValues[static_cast<size_t>(index)] ? rawValues[static_cast<size_t>(index)]->load() : parameters[static_cast<size_t>(index)].def };
+    smoothedParameters.push_back({ static_cast<uint32_t>(index), std::max(rampTimeSec, 0.f), value, value, 0.f, 0, false });
+    return static_cast<int>(smoothedParameters.size() - 1);
+}
+
+void ParameterManager::prepareSmoothing(double sampleRate, int maxBlockSize)
+{
+    smoothingSampleRate = sampleRate;
+    maxSmoothingBlockSize = std::max(maxBlockSize, 0);
+    smoothedBuffers.assign(smoothedParameters.size() * static_cast<size_t>(maxSmoothingBlockSize), 0.f);
+
+    for (auto& p : smoothedParameters)
     {
-        auto it = callbacks.find(newParam.second.first);
-        if (it != callbacks.end())
-            it->second(newParam.second.second, false);
-        newParam = fifo.popParameter();
+        p.target = rawValues[p.index] ? rawValues[p.index]->load() : parameters[p.index].def;
+        p.current = p.target;
+        p.step = 0.f;
+        p.stepsRemaining = 0;
+        p.bufferSettled = false;
     }
 }
 
+void ParameterManager::processSmoothing(int numSamples)
+{
+    jassert(numSamples <= maxSmoothingBlockSize);
+    numSamples = juce::jlimit(0, maxSmoothingBlockSize, numSamples);
+
+    for (size_t s = 0; s < smoothedParameters.size(); ++s)
+    {
+        auto& p { smoothedParameters[s] };
+        float* buffer { smoothedBuffers.data() + s * static_cast<size_t>(maxSmoothingBlockSize) };
+
+        const float target { rawValues[p.index] ? rawValues[p.index]->load(std::memory_order_relaxed) : p.target };
+        if (target != p.target)
+        {
+            p.target = target;
+            p.stepsRemaining = static_cast<int>(std::round(p.rampTimeSec * smoothingSampleRate));
+            p.step = p.stepsRemaining > 0 ? (p.target - p.current) / static_cast<float>(p.stepsRemaining) : 0.f;
+            if (p.stepsRemaining == 0)
+                p.current = p.target;
+            p.bufferSettled = false;
+        }
+
+        // A settled buffer already holds the target in every sample
+        if (p.bufferSettled)
+            continue;
+
+        const int rampSamples { std::min(p.stepsRemaining, numSamples) };
+        for (int n = 0; n < rampSamples; ++n)
+            buffer[n] = p.current + p.step * static_cast<float>(n + 1);
+
+        p.stepsRemaining -= rampSamples;
+        if (p.stepsRemaining == 0)
+        {
+            // The ramp still fills the start of the buffer if it ended in this block,
+            // so the buffer only settles once a block has filled it all with the target
+            p.current = p.target;
+            juce::FloatVectorOperations::fill(buffer + rampSamples, p.target, maxSmoothingBlockSize - rampSamples);
+            p.bufferSettled = rampSamples == 0;
+        }
+        else if (rampSamples > 0)
+        {
+            p.current = buffer[rampSamples - 1];
+        }
+    }
+}
+
+const float* ParameterManager::getSmoothedBuffer(int handle) const
+{
+    jassert(handle >= 0 && static_cast<size_t>(handle) < smoothedParameters.size());
+    return smoothedBuffers.data() + static_cast<size_t>(handle) * static_cast<size_t>(maxSmoothingBlockSize);
+}
+
+bool ParameterManager::isSmoothing(int handle) const
+{
+    jassert(handle >= 0 && static_cast<size_t>(handle) < smoothedParameters.size());
+    return smoothedParameters[static_cast<size_t>(handle)].stepsRemaining > 0;
+}
+
+int ParameterManager::getParameterIndex(const juce::String& ID) const
+{
+    for (size_t i = 0; i < parameters.size(); ++i)
+        if (parameters[i].ID == ID)
+            return static_cast<int>(i);
+    return -1;
+}
+
 void ParameterManager::clearParameterQueue()
 {
     fifo.clear();
+    for (auto& word : dirtyWords)
+        word.store(0, std::memory_order_relaxed);
 }
 
 const std::vector<mrta::ParameterInfo>& ParameterManager::getParameters() const
@@ -112,21 +302,102 @@ juce::AudioProcessorValueTreeState& ParameterManager::getAPVTS()
     return apvts;
 }
 
+static const uint32_t BinaryStateMagic { 0x4254524d }; // "MRTB" read as little endian
+static const uint32_t BinaryStateVersion { 1 };
+static const size_t BinaryStateHeaderSize { 3 * sizeof(uint32_t) };
+static const size_t BinaryStateEntrySize { 2 * sizeof(uint32_t) };
+
 void ParameterManager::setStateInformation(const void* data, int sizeInBytes)
 {
-    juce::ValueTree newState { juce::ValueTree::readFromData(data, sizeInBytes) };
+    if (data == nullptr || sizeInBytes <= 0)
+        return;
+
+    if (setBinaryState(data, static_cast<size_t>(sizeInBytes)))
+        return;
+
+    juce::ValueTree newState { juce::ValueTree::readFromData(data, static_cast<size_t>(sizeInBytes)) };
     apvts.replaceState(newState);
 }
 
 void ParameterManager::getStateInformation(juce::MemoryBlock& destData)
 {
-    juce::MemoryOutputStream mos(destData, false);
-    apvts.state.writeToStream(mos);
+    destData.setSize(BinaryStateHeaderSize + parameters.size() * BinaryStateEntrySize);
+    auto* out { static_cast<char*>(destData.getData()) };
+
+    auto writeUint32 = [&out] (uint32_t value)
+    {
+        value = juce::ByteOrder::swapIfBigEndian(value);
+        std::memcpy(out, &value, sizeof(value));
+        out += sizeof(value);
+    };
+
+    writeUint32(BinaryStateMagic);
+    writeUint32(BinaryStateVersion);
+    writeUint32(static_cast<uint32_t>(parameters.size()));
+
+    for (size_t i = 0; i < parameters.size(); ++i)
+    {
+        const float value { rawValues[i] != nullptr ? rawValues[i]->load() : parameters[i].def };
+        uint32_t valueBits;
+        std::memcpy(&valueBits, &value, sizeof(valueBits));
+
+        writeUint32(hashParameterID(parameters[i].ID));
+        writeUint32(valueBits);
+    }
 }
 
-void ParameterManager::parameterChanged(const juce::String& parameterID, float newValue)
+bool ParameterManager::setBinaryState(const void* data, size_t sizeInBytes)
 {
-    fifo.pushParameter(parameterID, newValue);
+    const auto* in { static_cast<const char*>(data) };
+    if (sizeInBytes < BinaryStateHeaderSize
+        || juce::ByteOrder::littleEndianInt(in) != BinaryStateMagic
+        || juce::ByteOrder::littleEndianInt(in + 4) != BinaryStateVersion)
+        return false;
+
+    // Divided rather than multiplied, a corrupt count must not wrap the bound on 32-bit hosts
+    const size_t count { juce::ByteOrder::littleEndianInt(in + 8) };
+    if (count > (sizeInBytes - BinaryStateHeaderSize) / BinaryStateEntrySize)
+        return false;
+
+    // Parameters missing from the snapshot go back to their defaults, as with the ValueTree format
+    std::vector<bool> restored(parameters.size(), false);
+
+    in += BinaryStateHeaderSize;
+    for (size_t e = 0; e < count; ++e, in += BinaryStateEntrySize)
+    {
+        const uint32_t hash { juce::ByteOrder::littleEndianInt(in) };
+        const uint32_t valueBits { juce::ByteOrder::littleEndianInt(in + 4) };
+        float value;
+        std::memcpy(&value, &valueBits, sizeof(value));
+
+        const auto it { std::lower_bound(hashToIndex.begin(), hashToIndex.end(), std::make_pair(hash, uint32_t { 0 })) };
+        if (it == hashToIndex.end() || it->first != hash || !std::isfinite(value))
+            continue;
+
+        const size_t index { it->second };
+        if (auto* parameter { parameterObjects[index] })
+        {
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+            restored[index] = true;
+        }
+    }
+
+    for (size_t i = 0; i < parameters.size(); ++i)
+        if (!restored[i] && parameterObjects[i] != nullptr)
+            parameterObjects[i]->setValueNotifyingHost(parameterObjects[i]->getDefaultValue());
+
+    return true;
+}
+
+uint32_t ParameterManager::hashParameterID(const juce::String& ID)
+{
+    uint32_t hash { 2166136261u };
+    for (const char* c { ID.toRawUTF8() }; *c != 0; ++c)
+    {
+        hash ^= static_cast<uint8_t>(*c);
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
 }
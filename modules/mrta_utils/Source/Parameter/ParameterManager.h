@@ -3,16 +3,29 @@
 namespace mrta
 {
 
-class ParameterManager : public juce::AudioProcessorValueTreeState::Listener
+class ParameterManager
 {
 public:
     // Callback function type alias
     using Callback = std::function<void(float value, bool forced)>;
 
+    // How parameter changes reach the callbacks
+    enum class UpdateMode
+    {
+        // Every change is queued and delivered in order, if the queue
+        // is full the latest value is delivered as in Coalesce
+        Queue,
+
+        // Only the latest value of each changed parameter is delivered,
+        // changes can never be lost and the cost is O(changed parameters)
+        Coalesce
+    };
+
     // Main ctor
     ParameterManager(juce::AudioProcessor& audioProcessor,
                      const juce::String& identifier,
-                     const std::vector<mrta::ParameterInfo>& parameters);
+                     const std::vector<mrta::ParameterInfo>& parameters,
+                     UpdateMode updateMode = UpdateMode::Queue);
 
     // No default ctor
     ParameterManager() = delete;
@@ -35,7 +48,71 @@ public:
     // good way to guarantee the DSP has updated parameters
     void updateParameters(bool force = false);
 
-    // Empty the paramter event queue
+    // Schedule a parameter change at a sample offset of the current block
+    // Audio thread only, meant for changes whose timing is known inside the
+    // block, e.g. mapped from MIDI, host changes are applied at offset 0
+    // Returns false if the ID is unknown or the event list is full
+    bool addTimedParameterChange(const juce::String& ID, float value, int sampleOffset);
+    bool addTimedParameterChange(int index, float value, int sampleOffset);
+
+    // Calls processSubBlock(startSample, numSubBlockSamples) for consecutive sub-blocks
+    // covering the block, split at every timed change and at most maxSubBlockSize samples long
+    // Before every sub-block, updateParameters delivers the host changes that arrived meanwhile,
+    // then the timed changes up to its start are applied, so a small maxSubBlockSize
+    // also bounds how long host changes wait with large buffers
+    template <typename ProcessFunction>
+    void processSubBlocks(int numSamples, int maxSubBlockSize, ProcessFunction&& processSubBlock)
+    {
+        jassert(maxSubBlockSize > 0);
+        maxSubBlockSize = std::max(maxSubBlockSize, 1);
+
+        updateParameters();
+
+        int startSample { 0 };
+        size_t nextEvent { 0 };
+        while (startSample < numSamples)
+        {
+            nextEvent = applyTimedChanges(nextEvent, startSample);
+
+            int endSample { std::min(numSamples, startSample + maxSubBlockSize) };
+            if (nextEvent < numTimedEvents)
+                endSample = std::min(endSample, timedEvents[nextEvent].sampleOffset);
+
+            processSubBlock(startSample, endSample - startSample);
+            startSample = endSample;
+
+            if (startSample < numSamples)
+                updateParameters();
+        }
+
+        // Changes past the end of the block take effect now
+        applyTimedChanges(nextEvent, std::numeric_limits<int>::max());
+        numTimedEvents = 0;
+    }
+
+    // Smoothing service, produces a block of linearly smoothed values per parameter
+    // Smoothed values follow the parameter directly, no callback is needed
+    // Enable the parameters in the processors ctor, returns a handle or -1 if the ID is unknown
+    int enableSmoothing(const juce::String& ID, float rampTimeSec);
+
+    // Allocate the smoothed buffers and jump to the current values, call on prepareToPlay
+    void prepareSmoothing(double sampleRate, int maxBlockSize);
+
+    // Fill the smoothed buffers of the next numSamples samples in one pass,
+    // parameters that are already settled are skipped, call on every process buffer
+    void processSmoothing(int numSamples);
+
+    // Smoothed values of the last processSmoothing call
+    const float* getSmoothedBuffer(int handle) const;
+
+    // True while the parameter is still moving towards its value
+    bool isSmoothing(int handle) const;
+
+    // Get the index of a parameter, its position in the parameter info vector
+    // Returns -1 if there is no parameter with this ID
+    int getParameterIndex(const juce::String& ID) const;
+
+    // Empty the paramter event queue and drop pending coalesced changes
     void clearParameterQueue();
 
     // Get a vector with all the parameters information structs
@@ -48,22 +125,94 @@ public:
     // Helper functions for serialising the current parameter
     // state, has the same signature as juce::AudioProcessor
     // uses for parameter state load and save
+    // Reads both the binary snapshot and the older ValueTree format
     void setStateInformation(const void* data, int sizeInBytes);
 
     // Helper functions for serialising the current parameter
     // state, has the same signature as juce::AudioProcessor
     // uses for parameter state load and save
+    // Writes a binary snapshot, little endian:
+    //   uint32 magic "MRTB", uint32 version, uint32 count,
+    //   then count times { uint32 parameter ID hash, float32 value }
     void getStateInformation(juce::MemoryBlock& destData);
 
-    // Parameter change listener, this function is not meant to
-    // be called by user, it is used by the APVTS listerners only
-    void parameterChanged(const juce::String& parameterID, float newValue) override;
-
 private:
+    // Forwards APVTS changes of one parameter to the FIFO tagged with its index,
+    // so neither the listener nor the audio thread has to look up the parameter ID
+    class ParameterListener : public juce::AudioProcessorValueTreeState::Listener
+    {
+    public:
+        ParameterListener(ParameterManager& _manager, uint32_t _index) : manager { _manager }, index { _index } { }
+        void parameterChanged(const juce::String&, float newValue) override { manager.pushParameter(index, newValue); }
+
+    private:
+        ParameterManager& manager;
+        const uint32_t index;
+    };
+
+    // Called from any thread that changes a parameter
+    void pushParameter(uint32_t index, float value);
+
+    // Restore a binary snapshot, returns false if the data is not one
+    bool setBinaryState(const void* data, size_t sizeInBytes);
+
+    // 32-bit FNV-1a of the UTF-8 ID, stable across sessions and JUCE versions
+    static uint32_t hashParameterID(const juce::String& ID);
+
+    // Call the callbacks of timed changes from first up to sampleOffset, returns the next one
+    size_t applyTimedChanges(size_t first, int sampleOffset);
+
+    struct TimedParameterEvent
+    {
+        uint32_t index;
+        float value;
+        int sampleOffset;
+    };
+
+    // Deliver the latest value of every parameter flagged dirty
+    void flushDirtyParameters();
+
     juce::AudioProcessorValueTreeState apvts;
     std::vector<mrta::ParameterInfo> parameters;
+    const UpdateMode updateMode;
     mrta::ParameterFIFO<64> fifo;
-    std::unordered_map<juce::String, Callback> callbacks;
+
+    // Latest value of every parameter and one dirty bit per parameter
+    // The value is stored before the bit is set, so whoever clears the bit reads it
+    static constexpr size_t BitsPerWord { 64 };
+    std::vector<std::atomic<float>> latestValues;
+    std::vector<std::atomic<uint64_t>> dirtyWords;
+
+    struct SmoothedParameter
+    {
+        uint32_t index;
+        float rampTimeSec;
+        float current;
+        float target;
+        float step;
+        int stepsRemaining;
+        bool bufferSettled;
+    };
+
+    // Smoothed parameters and their buffers, maxSmoothingBlockSize values each
+    std::vector<SmoothedParameter> smoothedParameters;
+    std::vector<float> smoothedBuffers;
+    double smoothingSampleRate { 48000.0 };
+    int maxSmoothingBlockSize { 0 };
+
+    // Timed changes of the current block sorted by sample offset, audio thread only
+    static constexpr size_t MaxTimedEvents { 128 };
+    std::array<TimedParameterEvent, MaxTimedEvents> timedEvents;
+    size_t numTimedEvents { 0 };
+
+    // Indexed like parameters, empty entries have no callback registered
+    std::vector<Callback> callbacks;
+    std::vector<std::atomic<float>*> rawValues;
+    std::vector<std::unique_ptr<ParameterListener>> listeners;
+
+    // Parameter objects indexed like parameters, and (ID hash, index) pairs sorted by hash
+    std::vector<juce::RangedAudioParameter*> parameterObjects;
+    std::vector<std::pair<uint32_t, uint32_t>> hashToIndex;
 
     JUCE_DECLARE_NON_COPYABLE(ParameterManager)
     JUCE_DECLARE_NON_MOVEABLE(ParameterManager)
@@ -1,32 +1,61 @@
 #pragma once
 
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
 #include <cmath>
+#include <type_traits>
 
 #include "GruParameters.h"
+#include "GruQuantizer.h"
+#include "SIMD.h"
 
 
-template <size_t INPUT_SIZE, size_t OUTPUT_SIZE, size_t HIDDEN_SIZE>
+// Single layer GRU with an affine output layer, following the PyTorch GRU equations
+//   r = sigmoid(W_ir x + b_ir + W_hr h + b_hr)
+//   z = sigmoid(W_iz x + b_iz + W_hz h + b_hz)
+//   n = tanh(W_in x + b_in + r * (W_hn h + b_hn))
+//   h = (1 - z) * n + z * h
+//   y = W_out h + b_out
+//
+// The r, z and n weights are fused into a single matrix per input, stored transposed
+// so each column of the matrix-vector product is a contiguous SIMD axpy:
+//   weight_hh[j] = [ W_hr[:, j], W_hz[:, j], W_hn[:, j] ]
+// SSE2 / NEON are used since they are the baseline of the architectures we build for
+//
+// BATCH_SIZE independent instances sharing the same weights are advanced together,
+// every weight vector is loaded once and applied to all hidden states
+// Inputs and outputs of the instances are interleaved per sample:
+//   input[n][b * INPUT_SIZE + j], output[n][b * OUTPUT_SIZE + i]
+//
+// The recurrent weights can be stored with reduced precision, see GruWeightType,
+// they are converted to floats when loaded into registers and accumulated in fp32
+
+// Activation functions used by the gates
+enum class GruActivation
+{
+    // std::exp / std::tanh
+    Exact,
+
+    // [7/6] Pade approximant of tanh, sigmoid(x) = 0.5 + 0.5 * tanh(x / 2), evaluated 4 gates at a time
+    // Max absolute error is 1e-4 for tanh and 5e-5 for sigmoid, on the bundled amp model the output
+    // error stays 35 dB below the output level, see tests/GruTest.cpp
+    Fast
+};
+
+template <size_t INPUT_SIZE, size_t OUTPUT_SIZE, size_t HIDDEN_SIZE,
+          GruActivation ACTIVATION = GruActivation::Exact, size_t BATCH_SIZE = 1,
+          GruWeightType WEIGHT_TYPE = GruWeightType::Float32>
 class Gru
 {
 public:
     Gru()
     {
-        memset(weight_ih_r, 0, sizeof(weight_ih_r));
-        memset(weight_ih_z, 0, sizeof(weight_ih_z));
-        memset(weight_ih_n, 0, sizeof(weight_ih_n));
-
-        memset(bias_ih_r, 0, sizeof(bias_ih_r));
-        memset(bias_ih_z, 0, sizeof(bias_ih_z));
-        memset(bias_ih_n, 0, sizeof(bias_ih_n));
-
-        memset(weight_hh_r, 0, sizeof(weight_hh_r));
-        memset(weight_hh_z, 0, sizeof(weight_hh_z));
-        memset(weight_hh_n, 0, sizeof(weight_hh_n));
-
-        memset(bias_hh_r, 0, sizeof(bias_hh_r));
-        memset(bias_hh_z, 0, sizeof(bias_hh_z));
-        memset(bias_hh_n, 0, sizeof(bias_hh_n));
+        memset(weight_ih, 0, sizeof(weight_ih));
+        memset(weight_hh, 0, sizeof(weight_hh));
+        memset(bias_ih, 0, sizeof(bias_ih));
+        memset(bias_hh, 0, sizeof(bias_hh));
+        memset(scale_hh, 0, sizeof(scale_hh));
 
         memset(weight_output, 0, sizeof(weight_output));
         memset(bias_output, 0, sizeof(bias_output));
@@ -36,114 +65,300 @@ public:
 
     float sigmoid(float x) const
     {
-        // TODO 1) Implement the sigmoid function
+        if constexpr (ACTIVATION == GruActivation::Fast)
+            return 0.5f + 0.5f * fast_tanh(0.5f * x);
+        else
+            return 1.f / (1.f + std::exp(-x));
+    }
+
+    float tanh(float x) const
+    {
+        if constexpr (ACTIVATION == GruActivation::Fast)
+            return fast_tanh(x);
+        else
+            return std::tanh(x);
     }
 
     void process(float * const * output, const float * const * input, size_t num_samples)
     {
-        float r_gate[HIDDEN_SIZE];
-        float z_gate[HIDDEN_SIZE];
-        float n_gate[HIDDEN_SIZE];
-        float n_hidden[HIDDEN_SIZE];
+        for (size_t offset = 0; offset < num_samples; offset += CHUNK_SIZE)
+        {
+            const size_t chunk_size { std::min(CHUNK_SIZE, num_samples - offset) };
 
-        for (size_t n = 0; n < num_samples; ++n)
+            // The input projection does not depend on the state, do it for the whole chunk at once
+            project_input(input + offset, chunk_size);
+
+            // Only the hidden projection remains in the recurrent loop
+            process_recurrent(output + offset, chunk_size);
+        }
+    }
+
+    void load_parameters(const GruParameters<INPUT_SIZE, OUTPUT_SIZE, HIDDEN_SIZE>& params)
+    {
+        load_parameters(GruParameterView::from_parameters(params));
+    }
+
+    void load_parameters(const GruParameterView& params)
+    {
+        // PyTorch matrices are row major [HIDDEN_SIZE][INPUT_SIZE], transpose them into the fused layout
+        const float* weights_ih[3] { params.weight_ih_r, params.weight_ih_z, params.weight_ih_n };
+        const float* weights_hh[3] { params.weight_hh_r, params.weight_hh_z, params.weight_hh_n };
+        const float* biases_ih[3] { params.bias_ih_r, params.bias_ih_z, params.bias_ih_n };
+        const float* biases_hh[3] { params.bias_hh_r, params.bias_hh_z, params.bias_hh_n };
+
+        for (size_t g = 0; g < 3; ++g)
         {
-            // Compute r gate - this is shown here as an example
             for (size_t i = 0; i < HIDDEN_SIZE; ++i)
             {
-                // Initialise with bias_ih
-                r_gate[i] = bias_ih_r[i];
-                // Implement matrix-vector multiply with weight_ih and the input signal
                 for (size_t j = 0; j < INPUT_SIZE; ++j)
-                {
-                    r_gate[i] += weight_ih_r[i][j] * input[n][j];
-                }
-                // Add bias_hh
-                r_gate[i] += bias_hh_r[i];
-                // Implement matrix-vector multiply with weight_hh and the state signal
-                for (size_t j = 0; j < HIDDEN_SIZE; ++j)
-                {
-                    r_gate[i] += weight_hh_r[i][j] * state[j];
-                }
-                // Apply sigmoid activation function
-                r_gate[i] = sigmoid(r_gate[i]);
-            }
+                    weight_ih[j][g * HIDDEN_SIZE + i] = weights_ih[g][i * INPUT_SIZE + j];
 
-            // TODO 2) Implement the z gate and store the result to z_gate.
-            for (size_t i = 0; i < HIDDEN_SIZE; ++i)
-            {
-            }
+                load_recurrent_row(g * HIDDEN_SIZE + i, weights_hh[g] + i * HIDDEN_SIZE);
 
-            // TODO 3) Compute n gate - note that this is different than the r and z gates
-            for (size_t i = 0; i < HIDDEN_SIZE; ++i)
-            {
-                // TODO 3.1) Compute W_in * x + b_in and store result to n_gate
-                // TODO 3.2) Compute W_h * h + b_h and store result to n_hidden
-                // TODO 3.3) Multiply n_hidden by the r gate
-                // TODO 3.4) Add n_hidden to n_gate
-                // TODO 3.5) Apply tanh activation function to n_gate
+                bias_ih[g * HIDDEN_SIZE + i] = biases_ih[g][i];
+                bias_hh[g * HIDDEN_SIZE + i] = biases_hh[g][i];
             }
+        }
 
-            // TODO 4) Compute the new state h_t = (1 - z) * n + z * h_{t-1}
-            for (size_t i = 0; i < HIDDEN_SIZE; ++i)
+        memcpy(weight_output, params.weight_output, sizeof(weight_output));
+        memcpy(bias_output, params.bias_output, sizeof(bias_output));
+    }
+
+    void reset_state()
+    {
+        memset(state, 0, sizeof(state));
+    }
+
+private:
+    using Float4 = DSP::SIMD::Float4;
+
+    using RecurrentWeight = std::conditional_t<WEIGHT_TYPE == GruWeightType::Int8, int8_t,
+                            std::conditional_t<WEIGHT_TYPE == GruWeightType::Float16, uint16_t, float>>;
+
+    // r, z and n gates stacked, padded to a whole number of SIMD vectors
+    static constexpr size_t GATES_SIZE { (3 * HIDDEN_SIZE + Float4::Size - 1) / Float4::Size * Float4::Size };
+    static constexpr size_t NUM_VECTORS { GATES_SIZE / Float4::Size };
+
+    // Largest divisor of NUM_VECTORS not above max_vectors, so all tiles are full
+    // and the accumulator loops have compile time bounds
+    static constexpr size_t tile_vectors(size_t max_vectors)
+    {
+        size_t v { std::min(max_vectors, NUM_VECTORS) };
+        while (NUM_VECTORS % v != 0)
+            --v;
+        return v;
+    }
+
+    // Accumulators the hidden product keeps in registers, 12 of the 16 SSE2 registers
+    static constexpr size_t MAX_ACCUMULATORS { 12 };
+    static constexpr size_t VECTORS_PER_TILE { tile_vectors(std::max(MAX_ACCUMULATORS / BATCH_SIZE, size_t { 1 })) };
+
+
+    // Gates below this index are evaluated with SIMD activations
+    static constexpr size_t VECTOR_GATES_END { ACTIVATION == GruActivation::Fast ? HIDDEN_SIZE / Float4::Size * Float4::Size : 0 };
+
+    // Convert one PyTorch row of a recurrent matrix, it becomes column `gate` of the transposed weights
+    void load_recurrent_row(size_t gate, const float* row)
+    {
+        if constexpr (WEIGHT_TYPE == GruWeightType::Int8)
+        {
+            int8_t quantized[HIDDEN_SIZE];
+            quantize_int8_rows(row, 1, HIDDEN_SIZE, quantized, scale_hh + gate);
+            for (size_t j = 0; j < HIDDEN_SIZE; ++j)
+                weight_hh[j][gate] = quantized[j];
+        }
+        else if constexpr (WEIGHT_TYPE == GruWeightType::Float16)
+        {
+            for (size_t j = 0; j < HIDDEN_SIZE; ++j)
+                weight_hh[j][gate] = float_to_half(row[j]);
+        }
+        else
+        {
+            for (size_t j = 0; j < HIDDEN_SIZE; ++j)
+                weight_hh[j][gate] = row[j];
+        }
+    }
+
+    static Float4 load_recurrent_weights(const RecurrentWeight* ptr)
+    {
+        if constexpr (WEIGHT_TYPE == GruWeightType::Int8)
+            return DSP::SIMD::loadInt8(ptr);
+        else if constexpr (WEIGHT_TYPE == GruWeightType::Float16)
+            return DSP::SIMD::loadHalf(ptr);
+        else
+            return DSP::SIMD::load(ptr);
+    }
+
+    // Number of samples whose input projection is computed ahead of the recurrent loop
+    static constexpr size_t CHUNK_SIZE { 64 };
+
+    // input_gates[n][b] = b_ih + W_ih x[n][b] for every sample of the chunk
+    // Each block of weights is held in registers while the chunk streams past
+    void project_input(const float * const * input, size_t num_samples)
+    {
+        for (size_t i = 0; i < GATES_SIZE; i += Float4::Size)
+        {
+            Float4 weights[INPUT_SIZE];
+            for (size_t j = 0; j < INPUT_SIZE; ++j)
+                weights[j] = DSP::SIMD::load(weight_ih[j] + i);
+            const Float4 bias { DSP::SIMD::load(bias_ih + i) };
+
+            for (size_t n = 0; n < num_samples; ++n)
             {
+                for (size_t b = 0; b < BATCH_SIZE; ++b)
+                {
+                    const float* x { input[n] + b * INPUT_SIZE };
+
+                    Float4 acc { bias };
+                    for (size_t j = 0; j < INPUT_SIZE; ++j)
+                        acc = acc + weights[j] * DSP::SIMD::broadcast(x[j]);
+                    DSP::SIMD::store(input_gates[n][b] + i, acc);
+                }
             }
+        }
+    }
+
+    void process_recurrent(float * const * output, size_t num_samples)
+    {
+        alignas(16) float gates_hh[BATCH_SIZE][GATES_SIZE];
 
-            // TODO 5) Implement the affine output layer - store final output to output[n][i]
-            for (size_t i = 0; i < OUTPUT_SIZE; ++i)
+        for (size_t n = 0; n < num_samples; ++n)
+        {
+            matrix_matrix(gates_hh, weight_hh, bias_hh, scale_hh, state);
+
+            for (size_t b = 0; b < BATCH_SIZE; ++b)
             {
+                update_state(state[b], input_gates[n][b], gates_hh[b]);
+
+                // Affine output layer
+                for (size_t i = 0; i < OUTPUT_SIZE; ++i)
+                {
+                    float y { bias_output[i] };
+                    for (size_t j = 0; j < HIDDEN_SIZE; ++j)
+                        y += weight_output[i][j] * state[b][j];
+                    output[n][b * OUTPUT_SIZE + i] = y;
+                }
             }
         }
     }
 
-    void load_parameters(GruParameters<INPUT_SIZE, OUTPUT_SIZE, HIDDEN_SIZE> params)
+    // Apply the gates to one hidden state, h_t = (1 - z) * n + z * h_{t-1}
+    void update_state(float* h, const float* gates_ih, const float* gates_hh) const
     {
-        memcpy(weight_ih_r, params.weight_ih_r, sizeof(weight_ih_r));
-        memcpy(weight_ih_z, params.weight_ih_z, sizeof(weight_ih_z));
-        memcpy(weight_ih_n, params.weight_ih_n, sizeof(weight_ih_n));
+        if constexpr (ACTIVATION == GruActivation::Fast)
+        {
+            const Float4 half { DSP::SIMD::broadcast(0.5f) };
+            for (size_t i = 0; i < VECTOR_GATES_END; i += Float4::Size)
+            {
+                const Float4 r_gate { half + half * fast_tanh(half * (DSP::SIMD::load(gates_ih + i) + DSP::SIMD::load(gates_hh + i))) };
+                const Float4 z_gate { half + half * fast_tanh(half * (DSP::SIMD::load(gates_ih + HIDDEN_SIZE + i) + DSP::SIMD::load(gates_hh + HIDDEN_SIZE + i))) };
+                const Float4 n_gate { fast_tanh(DSP::SIMD::load(gates_ih + 2 * HIDDEN_SIZE + i) + r_gate * DSP::SIMD::load(gates_hh + 2 * HIDDEN_SIZE + i)) };
+
+                DSP::SIMD::store(h + i, n_gate + z_gate * (DSP::SIMD::load(h + i) - n_gate));
+            }
+        }
 
-        memcpy(bias_ih_r, params.bias_ih_r, sizeof(bias_ih_r));
-        memcpy(bias_ih_z, params.bias_ih_z, sizeof(bias_ih_z));
-        memcpy(bias_ih_n, params.bias_ih_n, sizeof(bias_ih_n));
+        // Scalar activations, for all gates with exact math or for the ones that do not fill a vector
+        for (size_t i = VECTOR_GATES_END; i < HIDDEN_SIZE; ++i)
+        {
+            const float r_gate { sigmoid(gates_ih[i] + gates_hh[i]) };
+            const float z_gate { sigmoid(gates_ih[HIDDEN_SIZE + i] + gates_hh[HIDDEN_SIZE + i]) };
+            const float n_gate { tanh(gates_ih[2 * HIDDEN_SIZE + i] + r_gate * gates_hh[2 * HIDDEN_SIZE + i]) };
 
-        memcpy(weight_hh_r, params.weight_hh_r, sizeof(weight_hh_r));
-        memcpy(weight_hh_z, params.weight_hh_z, sizeof(weight_hh_z));
-        memcpy(weight_hh_n, params.weight_hh_n, sizeof(weight_hh_n));
+            h[i] = n_gate + z_gate * (h[i] - n_gate);
+        }
+    }
 
-        memcpy(bias_hh_r, params.bias_hh_r, sizeof(bias_hh_r));
-        memcpy(bias_hh_z, params.bias_hh_z, sizeof(bias_hh_z));
-        memcpy(bias_hh_n, params.bias_hh_n, sizeof(bias_hh_n));
+    // tanh(x) ~= x (135135 + 17325 x^2 + 378 x^4 + x^6) / (135135 + 62370 x^2 + 3150 x^4 + 28 x^6)
+    // The input is clamped so the powers cannot overflow and the output is clamped
+    // to [-1, 1], the approximant crosses 1 around |x| = 4.97 where the error peaks
+    static constexpr float TANH_INPUT_LIMIT { 9.f };
 
-        memcpy(weight_output, params.weight_output, sizeof(weight_output));
-        memcpy(bias_output, params.bias_output, sizeof(bias_output));
+    static float fast_tanh(float x)
+    {
+        x = std::min(std::max(x, -TANH_INPUT_LIMIT), TANH_INPUT_LIMIT);
+        const float x2 { x * x };
+        const float num { x * (135135.f + x2 * (17325.f + x2 * (378.f + x2))) };
+        const float den { 135135.f + x2 * (62370.f + x2 * (3150.f + x2 * 28.f)) };
+        return std::min(std::max(num / den, -1.f), 1.f);
     }
 
-    void reset_state()
+    static Float4 fast_tanh(Float4 x)
     {
-        memset(state, 0, sizeof(state));
+        using DSP::SIMD::broadcast;
+
+        x = DSP::SIMD::min(DSP::SIMD::max(x, broadcast(-TANH_INPUT_LIMIT)), broadcast(TANH_INPUT_LIMIT));
+        const Float4 x2 { x * x };
+        const Float4 num { x * (broadcast(135135.f) + x2 * (broadcast(17325.f) + x2 * (broadcast(378.f) + x2))) };
+        const Float4 den { broadcast(135135.f) + x2 * (broadcast(62370.f) + x2 * (broadcast(3150.f) + x2 * broadcast(28.f))) };
+        return DSP::SIMD::min(DSP::SIMD::max(num / den, broadcast(-1.f)), broadcast(1.f));
     }
 
-private:
-    // model parameters
-    float weight_ih_r[HIDDEN_SIZE][INPUT_SIZE];
-    float weight_ih_z[HIDDEN_SIZE][INPUT_SIZE];
-    float weight_ih_n[HIDDEN_SIZE][INPUT_SIZE];
+    // y[b] = bias + W x[b] for all instances, with W stored transposed as [HIDDEN_SIZE][GATES_SIZE]
+    // The gate vectors are split in tiles whose accumulators of all instances fit in registers,
+    // the columns are independent axpys and each weight vector is loaded once for the whole batch
+    // Int8 weights accumulate W_q x and apply the row scales before adding the bias
+    static void matrix_matrix(float (*y)[GATES_SIZE], const RecurrentWeight (*weight)[GATES_SIZE], const float* bias,
+                              const float* scale, const float (*x)[HIDDEN_SIZE])
+    {
+        for (size_t k0 = 0; k0 < NUM_VECTORS; k0 += VECTORS_PER_TILE)
+        {
+            const float* tile_bias { bias + k0 * Float4::Size };
 
-    float bias_ih_r[HIDDEN_SIZE];
-    float bias_ih_z[HIDDEN_SIZE];
-    float bias_ih_n[HIDDEN_SIZE];
+            Float4 acc[BATCH_SIZE][VECTORS_PER_TILE];
+            for (size_t b = 0; b < BATCH_SIZE; ++b)
+                for (size_t k = 0; k < VECTORS_PER_TILE; ++k)
+                    acc[b][k] = WEIGHT_TYPE == GruWeightType::Int8 ? DSP::SIMD::broadcast(0.f) : DSP::SIMD::load(tile_bias + k * Float4::Size);
 
-    float weight_hh_r[HIDDEN_SIZE][HIDDEN_SIZE];
-    float weight_hh_z[HIDDEN_SIZE][HIDDEN_SIZE];
-    float weight_hh_n[HIDDEN_SIZE][HIDDEN_SIZE];
+            for (size_t j = 0; j < HIDDEN_SIZE; ++j)
+            {
+                const RecurrentWeight* tile_weight { weight[j] + k0 * Float4::Size };
 
-    float bias_hh_r[HIDDEN_SIZE];
-    float bias_hh_z[HIDDEN_SIZE];
-    float bias_hh_n[HIDDEN_SIZE];
+                Float4 xj[BATCH_SIZE];
+                for (size_t b = 0; b < BATCH_SIZE; ++b)
+                    xj[b] = DSP::SIMD::broadcast(x[b][j]);
+
+                for (size_t k = 0; k < VECTORS_PER_TILE; ++k)
+                {
+                    const Float4 w { load_recurrent_weights(tile_weight + k * Float4::Size) };
+                    for (size_t b = 0; b < BATCH_SIZE; ++b)
+                        acc[b][k] = acc[b][k] + w * xj[b];
+                }
+            }
+
+            if constexpr (WEIGHT_TYPE == GruWeightType::Int8)
+            {
+                for (size_t k = 0; k < VECTORS_PER_TILE; ++k)
+                {
+                    const Float4 s { DSP::SIMD::load(scale + (k0 + k) * Float4::Size) };
+                    const Float4 c { DSP::SIMD::load(tile_bias + k * Float4::Size) };
+                    for (size_t b = 0; b < BATCH_SIZE; ++b)
+                        acc[b][k] = c + s * acc[b][k];
+                }
+            }
+
+            for (size_t b = 0; b < BATCH_SIZE; ++b)
+                for (size_t k = 0; k < VECTORS_PER_TILE; ++k)
+                    DSP::SIMD::store(y[b] + (k0 + k) * Float4::Size, acc[b][k]);
+        }
+    }
+
+    // model parameters, fused and transposed
+    alignas(16) float weight_ih[INPUT_SIZE][GATES_SIZE];
+    alignas(16) RecurrentWeight weight_hh[HIDDEN_SIZE][GATES_SIZE];
+
+    alignas(16) float bias_ih[GATES_SIZE];
+    alignas(16) float bias_hh[GATES_SIZE];
+
+    // per row scales of the int8 recurrent weights, unused otherwise
+    alignas(16) float scale_hh[GATES_SIZE];
 
     float weight_output[OUTPUT_SIZE][HIDDEN_SIZE];
     float bias_output[OUTPUT_SIZE];
 
-    // gru state
-    float state[HIDDEN_SIZE];
+    // gru states of all instances
+    alignas(16) float state[BATCH_SIZE][HIDDEN_SIZE];
+
+    // input projection of the current chunk
+    alignas(16) float input_gates[CHUNK_SIZE][BATCH_SIZE][GATES_SIZE];
 };
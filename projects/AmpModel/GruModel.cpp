@@ -0,0 +1,285 @@
+#include "GruModel.h"
+#include "Gru.h"
+
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+template <size_t HIDDEN_SIZE, GruWeightType WEIGHT_TYPE>
+class GruModelInstance : public GruModel
+{
+public:
+    explicit GruModelInstance(const GruParameterView& params)
+    {
+        gru.load_parameters(params);
+    }
+
+    void process(float * const * output, const float * const * input, size_t num_samples) override
+    {
+        gru.process(output, input, num_samples);
+    }
+
+    void reset_state() override
+    {
+        gru.reset_state();
+    }
+
+    size_t get_hidden_size() const override
+    {
+        return HIDDEN_SIZE;
+    }
+
+    GruWeightType get_weight_type() const override
+    {
+        return WEIGHT_TYPE;
+    }
+
+private:
+    Gru<GruModel::INPUT_SIZE, GruModel::OUTPUT_SIZE, HIDDEN_SIZE, GruActivation::Fast, GruModel::NUM_CHANNELS, WEIGHT_TYPE> gru;
+};
+
+// Every size in the list instantiates a Gru for each weight type, keep it short to bound compile time and binary size
+template <size_t... HIDDEN_SIZES>
+struct HiddenSizeList
+{
+    template <GruWeightType WEIGHT_TYPE>
+    static std::unique_ptr<GruModel> create(const GruParameterView& params, size_t hidden_size)
+    {
+        std::unique_ptr<GruModel> model;
+        ((hidden_size == HIDDEN_SIZES && (model = std::make_unique<GruModelInstance<HIDDEN_SIZES, WEIGHT_TYPE>>(params), true)) || ...);
+        return model;
+    }
+
+    static bool contains(size_t hidden_size)
+    {
+        return ((hidden_size == HIDDEN_SIZES) || ...);
+    }
+};
+
+using SupportedHiddenSizes = HiddenSizeList<8, 12, 16, 20, 24, 32, 40, 48, 64>;
+
+const char FileMagic[4] { 'M', 'G', 'R', 'U' };
+
+juce::uint32 read_uint32(const char* data, size_t offset)
+{
+    return juce::ByteOrder::littleEndianInt(data + offset);
+}
+
+
+bool is_valid_weight_type(juce::uint32 weight_type)
+{
+    return weight_type == static_cast<juce::uint32>(GruWeightType::Float32)
+        || weight_type == static_cast<juce::uint32>(GruWeightType::Float16)
+        || weight_type == static_cast<juce::uint32>(GruWeightType::Int8);
+}
+
+// Sizes of the parameter arrays in GruParameters order
+constexpr size_t NumArrays { 14 };
+
+std::array<size_t, NumArrays> get_array_sizes(size_t hidden_size)
+{
+    const size_t input_size { GruModel::INPUT_SIZE };
+    const size_t output_size { GruModel::OUTPUT_SIZE };
+    return { hidden_size * input_size, hidden_size * input_size, hidden_size * input_size,
+             hidden_size, hidden_size, hidden_size,
+             hidden_size * hidden_size, hidden_size * hidden_size, hidden_size * hidden_size,
+             hidden_size, hidden_size, hidden_size,
+             output_size * hidden_size, output_size };
+}
+
+// weight_hh_r, weight_hh_z and weight_hh_n, the arrays stored in the weight type of the file
+bool is_recurrent_matrix(size_t array_index)
+{
+    return array_index >= 6 && array_index < 9;
+}
+
+// Bytes of the parameters in a model file
+size_t get_parameter_bytes(size_t hidden_size, GruWeightType weight_type)
+{
+    const auto array_sizes { get_array_sizes(hidden_size) };
+
+    size_t bytes { 0 };
+    for (size_t a = 0; a < NumArrays; ++a)
+        bytes += is_recurrent_matrix(a) ? get_recurrent_matrix_bytes(weight_type, hidden_size) : array_sizes[a] * sizeof(float);
+    return bytes;
+}
+
+}
+
+std::unique_ptr<GruModel> GruModel::create(const GruParameterView& params, size_t hidden_size, GruWeightType weight_type)
+{
+    switch (weight_type)
+    {
+    case GruWeightType::Float16: return SupportedHiddenSizes::create<GruWeightType::Float16>(params, hidden_size);
+    case GruWeightType::Int8: return SupportedHiddenSizes::create<GruWeightType::Int8>(params, hidden_size);
+    case GruWeightType::Float32:
+    default: return SupportedHiddenSizes::create<GruWeightType::Float32>(params, hidden_size);
+    }
+}
+
+bool GruModel::is_supported_hidden_size(size_t hidden_size)
+{
+    return SupportedHiddenSizes::contains(hidden_size);
+}
+
+std::unique_ptr<GruModel> GruModel::load(const juce::File& file, juce::String& error)
+{
+    // fp32 parameters are used in place, which needs float32 in host byte order
+    if (juce::ByteOrder::isBigEndian())
+    {
+        error = "Model files are not supported on big endian hosts";
+        return nullptr;
+    }
+
+    const juce::MemoryMappedFile mapped { file, juce::MemoryMappedFile::readOnly };
+    const char* data { static_cast<const char*>(mapped.getData()) };
+    const size_t size { mapped.getSize() };
+
+    if (data == nullptr)
+    {
+        error = "Could not open " + file.getFullPathName();
+        return nullptr;
+    }
+
+    if (size < FILE_HEADER_SIZE || std::memcmp(data, FileMagic, sizeof(FileMagic)) != 0)
+    {
+        error = file.getFileName() + " is not a GRU model file";
+        return nullptr;
+    }
+
+    const juce::uint32 version { read_uint32(data, 4) };
+    const size_t input_size { read_uint32(data, 8) };
+    const size_t output_size { read_uint32(data, 12) };
+    const size_t hidden_size { read_uint32(data, 16) };
+    const size_t num_parameters { read_uint32(data, 20) };
+    const size_t data_offset { read_uint32(data, 24) };
+    const juce::uint32 weight_type_value { read_uint32(data, 28) };
+
+    // Version 1 is fp32 only, with the weight type field reserved
+    if (version != 1u && version != FILE_VERSION)
+    {
+        error = "Unsupported model file version " + juce::String { version };
+        return nullptr;
+    }
+
+    if (!is_valid_weight_type(weight_type_value) || (version == 1u && weight_type_value != 0u))
+    {
+        error = "Unsupported recurrent weight type " + juce::String { weight_type_value };
+        return nullptr;
+    }
+
+    const GruWeightType weight_type { static_cast<GruWeightType>(weight_type_value) };
+
+    if (input_size != INPUT_SIZE || output_size != OUTPUT_SIZE)
+    {
+        error = "The model has " + juce::String { input_size } + " inputs and " + juce::String { output_size }
+              + " outputs, expected " + juce::String { INPUT_SIZE } + " and " + juce::String { OUTPUT_SIZE };
+        return nullptr;
+    }
+
+    if (!is_supported_hidden_size(hidden_size))
+    {
+        error = "Hidden size " + juce::String { hidden_size } + " is not supported";
+        return nullptr;
+    }
+
+    if (num_parameters != GruParameterView::get_num_parameters(input_size, output_size, hidden_size)
+        || data_offset < FILE_HEADER_SIZE || data_offset % 16 != 0
+        || data_offset + get_parameter_bytes(hidden_size, weight_type) > size)
+    {
+        error = file.getFileName() + " is corrupt or truncated";
+        return nullptr;
+    }
+
+    if (weight_type == GruWeightType::Float32)
+    {
+        // The mapping is page aligned, so the parameters are aligned as well
+        const float* parameters { reinterpret_cast<const float*>(data + data_offset) };
+        return create(GruParameterView::from_data(parameters, input_size, output_size, hidden_size), hidden_size);
+    }
+
+    // Reduced precision recurrent matrices are expanded to floats, the Gru stores them in their type again
+    std::vector<float> parameters(num_parameters);
+    const unsigned char* source { reinterpret_cast<const unsigned char*>(data + data_offset) };
+    float* destination { parameters.data() };
+    const auto array_sizes { get_array_sizes(hidden_size) };
+    for (size_t a = 0; a < NumArrays; ++a)
+    {
+        if (is_recurrent_matrix(a))
+        {
+            decode_recurrent_matrix(weight_type, source, hidden_size, destination);
+            source += get_recurrent_matrix_bytes(weight_type, hidden_size);
+        }
+        else
+        {
+            std::memcpy(destination, source, array_sizes[a] * sizeof(float));
+            source += array_sizes[a] * sizeof(float);
+        }
+
+        destination += array_sizes[a];
+    }
+
+    return create(GruParameterView::from_data(parameters.data(), input_size, output_size, hidden_size), hidden_size, weight_type);
+}
+
+bool GruModel::save(const juce::File& file, const GruParameterView& params, size_t hidden_size, GruWeightType weight_type)
+{
+    juce::FileOutputStream stream { file };
+    if (!stream.openedOk())
+        return false;
+
+    stream.setPosition(0);
+    stream.truncate();
+
+    const size_t num_parameters { GruParameterView::get_num_parameters(INPUT_SIZE, OUTPUT_SIZE, hidden_size) };
+
+    // fp32 models keep version 1, so builds without reduced precision support still read them
+    stream.write(FileMagic, sizeof(FileMagic));
+    stream.writeInt(static_cast<int>(weight_type == GruWeightType::Float32 ? 1u : FILE_VERSION));
+    stream.writeInt(static_cast<int>(INPUT_SIZE));
+    stream.writeInt(static_cast<int>(OUTPUT_SIZE));
+    stream.writeInt(static_cast<int>(hidden_size));
+    stream.writeInt(static_cast<int>(num_parameters));
+    stream.writeInt(static_cast<int>(FILE_HEADER_SIZE));
+    stream.writeInt(static_cast<int>(weight_type));
+
+    const std::pair<const float*, size_t> arrays[NumArrays]
+    {
+        { params.weight_ih_r, hidden_size * INPUT_SIZE },
+        { params.weight_ih_z, hidden_size * INPUT_SIZE },
+        { params.weight_ih_n, hidden_size * INPUT_SIZE },
+        { params.bias_ih_r, hidden_size },
+        { params.bias_ih_z, hidden_size },
+        { params.bias_ih_n, hidden_size },
+        { params.weight_hh_r, hidden_size * hidden_size },
+        { params.weight_hh_z, hidden_size * hidden_size },
+        { params.weight_hh_n, hidden_size * hidden_size },
+        { params.bias_hh_r, hidden_size },
+        { params.bias_hh_z, hidden_size },
+        { params.bias_hh_n, hidden_size },
+        { params.weight_output, OUTPUT_SIZE * hidden_size },
+        { params.bias_output, OUTPUT_SIZE }
+    };
+
+    for (size_t a = 0; a < NumArrays; ++a)
+    {
+        const auto& [values, count] { arrays[a] };
+        if (is_recurrent_matrix(a) && weight_type != GruWeightType::Float32)
+        {
+            std::vector<unsigned char> encoded(get_recurrent_matrix_bytes(weight_type, hidden_size));
+            encode_recurrent_matrix(weight_type, values, hidden_size, encoded.data());
+            stream.write(encoded.data(), encoded.size());
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+                stream.writeFloat(values[i]);
+        }
+    }
+
+    stream.flush();
+    return stream.getStatus().wasOk();
+}
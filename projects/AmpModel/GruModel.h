@@ -0,0 +1,61 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <memory>
+
+#include "GruParameters.h"
+#include "GruQuantizer.h"
+
+// Stereo amp model whose hidden size is only known at runtime
+// Each supported hidden size is a pre-instantiated Gru, selected when the model is created
+//
+// Model files (.mgru) are little endian and memory mapped, fp32 parameters are transposed
+// straight from the mapping into the aligned buffers of the Gru:
+//   offset  0: magic "MGRU"
+//   offset  4: uint32 format version
+//   offset  8: uint32 input size
+//   offset 12: uint32 output size
+//   offset 16: uint32 hidden size
+//   offset 20: uint32 number of parameters
+//   offset 24: uint32 byte offset of the parameters, a multiple of 16
+//   offset 28: uint32 GruWeightType of the recurrent matrices, reserved and 0 in version 1
+//   parameters: in GruParameters order, PyTorch row major matrices, float32 except the
+//               three recurrent matrices, which are stored as get_recurrent_matrix_bytes describes
+// Reduced precision files are expanded to floats when loaded and the Gru stores them in their type again
+class GruModel
+{
+public:
+    static constexpr size_t INPUT_SIZE { 3u };
+    static constexpr size_t OUTPUT_SIZE { 1u };
+    static constexpr size_t NUM_CHANNELS { 2u };
+
+    static constexpr juce::uint32 FILE_VERSION { 2u };
+    static constexpr size_t FILE_HEADER_SIZE { 32u };
+
+    virtual ~GruModel() = default;
+
+    // Process both channels, inputs and outputs are interleaved per sample as in Gru
+    virtual void process(float * const * output, const float * const * input, size_t num_samples) = 0;
+
+    virtual void reset_state() = 0;
+
+    virtual size_t get_hidden_size() const = 0;
+
+    virtual GruWeightType get_weight_type() const = 0;
+
+    // Create a model whose recurrent weights are stored in the given type,
+    // returns nullptr if the hidden size is not supported
+    static std::unique_ptr<GruModel> create(const GruParameterView& params, size_t hidden_size,
+                                            GruWeightType weight_type = GruWeightType::Float32);
+
+    // Load a model file, returns nullptr and describes the problem in error if it is invalid
+    static std::unique_ptr<GruModel> load(const juce::File& file, juce::String& error);
+
+    // Write parameters to a model file, quantizing the recurrent weights to the given type,
+    // returns false if it could not be written
+    static bool save(const juce::File& file, const GruParameterView& params, size_t hidden_size,
+                     GruWeightType weight_type = GruWeightType::Float32);
+
+    // Hidden sizes with a pre-instantiated Gru
+    static bool is_supported_hidden_size(size_t hidden_size);
+};
@@ -24,3 +24,73 @@ struct GruParameters
     float weight_output[OUTPUT_SIZE * HIDDEN_SIZE];
     float bias_output[OUTPUT_SIZE];
 };
+
+
+// Non-owning view of GRU parameters laid out like GruParameters, with the
+// sizes only known at runtime, e.g. the data block of a memory mapped model file
+struct GruParameterView
+{
+    const float * weight_ih_r;
+    const float * weight_ih_z;
+    const float * weight_ih_n;
+
+    const float * bias_ih_r;
+    const float * bias_ih_z;
+    const float * bias_ih_n;
+
+    const float * weight_hh_r;
+    const float * weight_hh_z;
+    const float * weight_hh_n;
+
+    const float * bias_hh_r;
+    const float * bias_hh_z;
+    const float * bias_hh_n;
+
+    const float * weight_output;
+    const float * bias_output;
+
+    // Number of floats of a contiguous parameter block
+    static size_t get_num_parameters(size_t input_size, size_t output_size, size_t hidden_size)
+    {
+        return 3 * hidden_size * input_size + 6 * hidden_size + 3 * hidden_size * hidden_size
+             + output_size * hidden_size + output_size;
+    }
+
+    // View of a contiguous parameter block in GruParameters order
+    static GruParameterView from_data(const float * data, size_t input_size, size_t output_size, size_t hidden_size)
+    {
+        GruParameterView view;
+        auto take = [&data] (size_t size) { const float * p = data; data += size; return p; };
+
+        view.weight_ih_r = take(hidden_size * input_size);
+        view.weight_ih_z = take(hidden_size * input_size);
+        view.weight_ih_n = take(hidden_size * input_size);
+
+        view.bias_ih_r = take(hidden_size);
+        view.bias_ih_z = take(hidden_size);
+        view.bias_ih_n = take(hidden_size);
+
+        view.weight_hh_r = take(hidden_size * hidden_size);
+        view.weight_hh_z = take(hidden_size * hidden_size);
+        view.weight_hh_n = take(hidden_size * hidden_size);
+
+        view.bias_hh_r = take(hidden_size);
+        view.bias_hh_z = take(hidden_size);
+        view.bias_hh_n = take(hidden_size);
+
+        view.weight_output = take(output_size * hidden_size);
+        view.bias_output = take(output_size);
+        return view;
+    }
+
+    // View of compile time sized parameters
+    template <size_t INPUT_SIZE, size_t OUTPUT_SIZE, size_t HIDDEN_SIZE>
+    static GruParameterView from_parameters(const GruParameters<INPUT_SIZE, OUTPUT_SIZE, HIDDEN_SIZE>& params)
+    {
+        return { params.weight_ih_r, params.weight_ih_z, params.weight_ih_n,
+                 params.bias_ih_r, params.bias_ih_z, params.bias_ih_n,
+                 params.weight_hh_r, params.weight_hh_z, params.weight_hh_n,
+                 params.bias_hh_r, params.bias_hh_z, params.bias_hh_n,
+                 params.weight_output, params.bias_output };
+    }
+};
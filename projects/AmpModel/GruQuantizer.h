@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Reduced precision storage for the recurrent GRU weights
+// Conversions are done once when the parameters are loaded or a model file is written, never on the audio thread
+// The values are stored in model files, do not renumber them
+// The bundled model is small enough to stay in L1 as fp32, there the conversions make both reduced types
+// about 1.5x slower, see tests/GruBenchmark.cpp, they pay off once the weights no longer fit in cache
+enum class GruWeightType : uint32_t
+{
+    // Plain fp32
+    Float32 = 0,
+
+    // IEEE half precision, relative error below 5e-4, halves the weight memory
+    // On the bundled amp model the output error stays 60 dB below the output level, see tests/GruTest.cpp
+    Float16 = 1,
+
+    // Symmetric int8 with one fp32 scale per PyTorch matrix row, quarters the weight memory
+    // On the bundled amp model the output error stays 30 dB below the output level
+    Int8 = 2
+};
+
+// Round a float to the nearest half precision value, returned as raw bits
+// Values below the smallest normal half are flushed to zero and large ones are clamped to
+// the largest finite half, so the SIMD conversion back only has to handle normal numbers
+inline uint16_t float_to_half(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+
+    const float magnitude = std::fabs(x);
+    if (!(magnitude >= 6.103515625e-05f))
+        return sign;
+    if (magnitude >= 65504.f)
+        return static_cast<uint16_t>(sign | 0x7bffu);
+
+    // Round to nearest even on the 13 mantissa bits that are dropped, a carry moves into the exponent
+    memcpy(&bits, &magnitude, sizeof(bits));
+    bits += 0x0fffu + ((bits >> 13) & 1u);
+    return static_cast<uint16_t>(sign | ((bits >> 13) - ((127u - 15u) << 10)));
+}
+
+// Quantize a row major matrix to int8 with one scale per row, w ~= scale[i] * q[i][j]
+// The scale maps the largest magnitude of the row to 127, all zero rows get a scale of 0
+inline void quantize_int8_rows(const float* matrix, size_t num_rows, size_t num_cols, int8_t* quantized, float* scales)
+{
+    for (size_t i = 0; i < num_rows; ++i)
+    {
+        const float* row = matrix + i * num_cols;
+
+        float max_abs = 0.f;
+        for (size_t j = 0; j < num_cols; ++j)
+            max_abs = std::max(max_abs, std::fabs(row[j]));
+
+        const float scale = max_abs / 127.f;
+        const float inv_scale = max_abs > 0.f ? 127.f / max_abs : 0.f;
+        for (size_t j = 0; j < num_cols; ++j)
+            quantized[i * num_cols + j] = static_cast<int8_t>(std::lround(std::min(std::max(row[j] * inv_scale, -127.f), 127.f)));
+
+        scales[i] = scale;
+    }
+}
+
+// Convert half precision bits from float_to_half back to a float, zeros and normal halves only
+inline float half_to_float(uint16_t h)
+{
+    const uint32_t sign = static_cast<uint32_t>(h & 0x8000u) << 16;
+    const uint32_t magnitude = h & 0x7fffu;
+    const uint32_t bits = sign | (magnitude == 0 ? 0u : (magnitude << 13) + ((127u - 15u) << 23));
+
+    float x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// Storage of a recurrent matrix in a model file, little endian whatever the host
+//   Float32: the row major floats
+//   Float16: the row major half bits
+//   Int8:    one fp32 scale per row, then the row major int8 weights
+inline size_t get_recurrent_matrix_bytes(GruWeightType type, size_t hidden_size)
+{
+    switch (type)
+    {
+    case GruWeightType::Float16: return 2 * hidden_size * hidden_size;
+    case GruWeightType::Int8: return 4 * hidden_size + hidden_size * hidden_size;
+    case GruWeightType::Float32:
+    default: return 4 * hidden_size * hidden_size;
+    }
+}
+
+// Write a row major recurrent matrix of hidden_size x hidden_size in the storage of a weight type
+inline void encode_recurrent_matrix(GruWeightType type, const float* matrix, size_t hidden_size, unsigned char* dest)
+{
+    auto write_uint32 = [&dest] (uint32_t x) { for (int i = 0; i < 4; ++i) *dest++ = static_cast<unsigned char>(x >> (8 * i)); };
+    auto write_float = [&write_uint32] (float x) { uint32_t bits; memcpy(&bits, &x, sizeof(bits)); write_uint32(bits); };
+
+    const size_t num_weights = hidden_size * hidden_size;
+    if (type == GruWeightType::Float16)
+    {
+        for (size_t i = 0; i < num_weights; ++i)
+        {
+            const uint16_t h = float_to_half(matrix[i]);
+            *dest++ = static_cast<unsigned char>(h);
+            *dest++ = static_cast<unsigned char>(h >> 8);
+        }
+    }
+    else if (type == GruWeightType::Int8)
+    {
+        std::vector<int8_t> quantized(num_weights);
+        std::vector<float> scales(hidden_size);
+        quantize_int8_rows(matrix, hidden_size, hidden_size, quantized.data(), scales.data());
+
+        for (const float scale : scales)
+            write_float(scale);
+        memcpy(dest, quantized.data(), num_weights);
+    }
+    else
+    {
+        for (size_t i = 0; i < num_weights; ++i)
+            write_float(matrix[i]);
+    }
+}
+
+// Expand a recurrent matrix stored by encode_recurrent_matrix back to row major floats
+// Loading the floats into a Gru of the same weight type gives the stored weights again,
+// int8 scales may move by a rounding step
+inline void decode_recurrent_matrix(GruWeightType type, const unsigned char* src, size_t hidden_size, float* matrix)
+{
+    auto read_uint32 = [&src] { uint32_t x = 0; for (int i = 0; i < 4; ++i) x |= static_cast<uint32_t>(*src++) << (8 * i); return x; };
+    auto read_float = [&read_uint32] { const uint32_t bits = read_uint32(); float x; memcpy(&x, &bits, sizeof(x)); return x; };
+
+    const size_t num_weights = hidden_size * hidden_size;
+    if (type == GruWeightType::Float16)
+    {
+        for (size_t i = 0; i < num_weights; ++i, src += 2)
+            matrix[i] = half_to_float(static_cast<uint16_t>(src[0] | (src[1] << 8)));
+    }
+    else if (type == GruWeightType::Int8)
+    {
+        const unsigned char* quantized = src + 4 * hidden_size;
+        for (size_t i = 0; i < hidden_size; ++i)
+        {
+            const float scale = read_float();
+            for (size_t j = 0; j < hidden_size; ++j)
+                matrix[i * hidden_size + j] = scale * static_cast<float>(static_cast<int8_t>(quantized[i * hidden_size + j]));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < num_weights; ++i)
+            matrix[i] = read_float();
+    }
+}
@@ -1,18 +1,31 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+static const int LoadButtonHeight { 30 };
+
 AmpModelProcessorEditor::AmpModelProcessorEditor(AmpModelProcessor& p) :
     AudioProcessorEditor(&p), audioProcessor(p),
     genericParameterEditor(audioProcessor.getParameterManager())
 {
     int height = static_cast<int>(audioProcessor.getParameterManager().getParameters().size())
                * genericParameterEditor.parameterWidgetHeight;
-    setSize(300, height);
+    setSize(300, height + LoadButtonHeight);
     addAndMakeVisible(genericParameterEditor);
+
+    loadModelButton.onClick = [this] { chooseModelFile(); };
+    addAndMakeVisible(loadModelButton);
+
+    exportModelButton.onClick = [this] { chooseExportWeightType(); };
+    addAndMakeVisible(exportModelButton);
+
+    // A session restored before the editor opened may have reported a missing model file already
+    audioProcessor.getModelErrorBroadcaster().addChangeListener(this);
+    showModelError();
 }
 
 AmpModelProcessorEditor::~AmpModelProcessorEditor()
 {
+    audioProcessor.getModelErrorBroadcaster().removeChangeListener(this);
 }
 
 void AmpModelProcessorEditor::paint (juce::Graphics& g)
@@ -22,5 +35,78 @@ void AmpModelProcessorEditor::paint (juce::Graphics& g)
 
 void AmpModelProcessorEditor::resized()
 {
-    genericParameterEditor.setBounds(getLocalBounds());
+    auto localBounds { getLocalBounds() };
+    auto buttonBounds { localBounds.removeFromBottom(LoadButtonHeight) };
+    loadModelButton.setBounds(buttonBounds.removeFromLeft(buttonBounds.getWidth() / 2).reduced(4));
+    exportModelButton.setBounds(buttonBounds.reduced(4));
+    genericParameterEditor.setBounds(localBounds);
+}
+
+void AmpModelProcessorEditor::chooseModelFile()
+{
+    modelChooser = std::make_unique<juce::FileChooser>("Load amp model", juce::File {}, "*.mgru");
+    modelChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+    [this] (const juce::FileChooser& chooser)
+    {
+        const juce::File file { chooser.getResult() };
+        if (file == juce::File {})
+            return;
+
+        loadModelButton.setEnabled(false);
+        audioProcessor.loadModelAsync(file,
+        [editor = juce::Component::SafePointer<AmpModelProcessorEditor>(this)] (const juce::String& error)
+        {
+            if (editor == nullptr)
+                return;
+
+            editor->loadModelButton.setEnabled(true);
+            if (error.isNotEmpty())
+                juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Load Model", error);
+        });
+    });
+}
+
+void AmpModelProcessorEditor::chooseExportWeightType()
+{
+    // Item IDs are the GruWeightType values plus one, 0 is a dismissed menu
+    juce::PopupMenu menu;
+    menu.addItem(static_cast<int>(GruWeightType::Float32) + 1, "fp32 weights");
+    menu.addItem(static_cast<int>(GruWeightType::Float16) + 1, "fp16 recurrent weights");
+    menu.addItem(static_cast<int>(GruWeightType::Int8) + 1, "int8 recurrent weights");
+
+    menu.showMenuAsync(juce::PopupMenu::Options {}.withTargetComponent(&exportModelButton),
+    [editor = juce::Component::SafePointer<AmpModelProcessorEditor>(this)] (int result)
+    {
+        if (editor != nullptr && result > 0)
+            editor->chooseExportFile(static_cast<GruWeightType>(result - 1));
+    });
+}
+
+void AmpModelProcessorEditor::chooseExportFile(GruWeightType weightType)
+{
+    modelChooser = std::make_unique<juce::FileChooser>("Export the built-in amp model", juce::File {}, "*.mgru");
+    modelChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles
+                            | juce::FileBrowserComponent::warnAboutOverwriting,
+    [this, weightType] (const juce::FileChooser& chooser)
+    {
+        const juce::File file { chooser.getResult() };
+        if (file == juce::File {})
+            return;
+
+        if (!audioProcessor.exportDefaultModel(file.withFileExtension("mgru"), weightType))
+            juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Export Model",
+                                                   "Could not write " + file.getFullPathName());
+    });
+}
+
+void AmpModelProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* /*source*/)
+{
+    showModelError();
+}
+
+void AmpModelProcessorEditor::showModelError()
+{
+    const juce::String error { audioProcessor.takeModelError() };
+    if (error.isNotEmpty())
+        juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Load Model", error);
 }
@@ -3,7 +3,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
-class AmpModelProcessorEditor : public juce::AudioProcessorEditor
+class AmpModelProcessorEditor : public juce::AudioProcessorEditor,
+                                public juce::ChangeListener
 {
 public:
     AmpModelProcessorEditor(AmpModelProcessor&);
@@ -12,9 +13,20 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
 
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+
 private:
     AmpModelProcessor& audioProcessor;
     mrta::GenericParameterEditor genericParameterEditor;
 
+    juce::TextButton loadModelButton { "Load Model" };
+    juce::TextButton exportModelButton { "Export Model" };
+    std::unique_ptr<juce::FileChooser> modelChooser;
+
+    void chooseModelFile();
+    void chooseExportWeightType();
+    void chooseExportFile(GruWeightType weightType);
+    void showModelError();
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AmpModelProcessorEditor)
 };
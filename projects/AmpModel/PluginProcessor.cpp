@@ -5,51 +5,74 @@
 static const std::vector<mrta::ParameterInfo> ParameterInfos
 {
     { Param::ID::Volume,  Param::Name::Volume,  "", 0.0f, 0.0, 1.f, 0.1f, 1.0f },
-    { Param::ID::Tone,  Param::Name::Tone,  "", 0.0f, 0.0f, 1.f, 0.1f, 1.0f }
+    { Param::ID::Tone,  Param::Name::Tone,  "", 0.0f, 0.0f, 1.f, 0.1f, 1.0f },
+    { Param::ID::Oversampling, Param::Name::Oversampling, { "1x", "2x", "4x" }, 0 }
 };
 
+// Session state: magic, version, size of the parameter state, parameter state, model path
+// States without the magic are plain parameter states of older versions
+static const int StateMagic { 0x5341524d }; // "MRAS" read as little endian
+static const int StateVersion { 1 };
+
 AmpModelProcessor::AmpModelProcessor() :
     parameterManager(*this, ProjectInfo::projectName, ParameterInfos)
 {
-    parameterManager.registerParameterCallback(Param::ID::Volume,
-    [this] (float value, bool forced)
-    {
-        DBG(Param::Name::Volume + ": " + juce::String { value });
-        // multiply by 0.8f because that's how it was trained
-        if (forced)
-            volume.setCurrentAndTargetValue(value * 0.8f);
-        else
-            volume.setTargetValue(value * 0.8f);
-    });
-    parameterManager.registerParameterCallback(Param::ID::Tone,
-    [this] (float value, bool forced)
+    // Volume and tone are smoothed by the parameter manager, the model sees them at the host rate
+    volumeSmoothing = parameterManager.enableSmoothing(Param::ID::Volume, 0.01f);
+    toneSmoothing = parameterManager.enableSmoothing(Param::ID::Tone, 0.01f);
+
+    parameterManager.registerParameterCallback(Param::ID::Oversampling,
+    [this] (float value, bool /*forced*/)
     {
-        DBG(Param::Name::Tone + ": " + juce::String { value });
-        // multiply by 0.8f because that's how it was trained
-        if (forced)
-            tone.setCurrentAndTargetValue(value * 0.8f);
-        else
-            tone.setTargetValue(value * 0.8f);
+        DBG(Param::Name::Oversampling + ": " + juce::String { value });
+        const size_t newStages { std::min(static_cast<size_t>(std::floor(value)), MAX_OVERSAMPLING_STAGES) };
+        if (newStages > 0)
+            oversamplers[newStages - 1]->reset();
+
+        oversamplingStages = newStages;
+        setLatencySamples(newStages > 0 ? static_cast<int>(oversamplers[newStages - 1]->getLatencyInSamples()) : 0);
     });
 
-    gru[0].load_parameters(gruParameters.params);
-    gru[1].load_parameters(gruParameters.params);
+    // Polyphase halfband IIR stages, the integer latency keeps the dry path of the host aligned
+    for (size_t stages = 1; stages <= MAX_OVERSAMPLING_STAGES; ++stages)
+        oversamplers[stages - 1] = std::make_unique<juce::dsp::Oversampling<float>>(NUM_CHANNELS, stages,
+                                                                                     juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                                     true, true);
+
+    // The compiled in model is the default until a model file is loaded
+    model = GruModel::create(GruParameterView::from_parameters(gruParameters.params), HIDDEN_SIZE);
 }
 
 AmpModelProcessor::~AmpModelProcessor()
 {
+    modelLoader.removeAllJobs(true, -1);
+    delete pendingModel.exchange(nullptr);
+    collectRetiredModel();
 }
 
 void AmpModelProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
     juce::uint32 numChannels { static_cast<juce::uint32>(std::max(getMainBusNumInputChannels(), getMainBusNumOutputChannels())) };
-    volume.reset(sampleRate, 0.01f);
-    tone.reset(sampleRate, 0.01f);
+    parameterManager.prepareSmoothing(sampleRate, samplesPerBlock);
+
+    // All factors are prepared so switching at runtime does not allocate
+    for (auto& oversampler : oversamplers)
+        oversampler->initProcessing(static_cast<size_t>(samplesPerBlock));
+
     parameterManager.updateParameters(true);
-    nnInputBuffer.setSize(samplesPerBlock, INPUT_SIZE);
-    nnOutputBuffer.setSize(samplesPerBlock, OUTPUT_SIZE);
-    gru[0].reset_state();
-    gru[1].reset_state();
+
+    const int maxModelSamples { samplesPerBlock << MAX_OVERSAMPLING_STAGES };
+    oversamplingBuffer.setSize(static_cast<int>(NUM_CHANNELS), samplesPerBlock);
+    nnInputBuffer.setSize(maxModelSamples, INPUT_SIZE * NUM_CHANNELS);
+    nnOutputBuffer.setSize(maxModelSamples, OUTPUT_SIZE * NUM_CHANNELS);
+    nnFadeBuffer.setSize(maxModelSamples, OUTPUT_SIZE * NUM_CHANNELS);
+
+    // Not running concurrently with processBlock, a pending model can be adopted without a crossfade
+    if (GruModel* incoming { pendingModel.exchange(nullptr, std::memory_order_acquire) })
+        model.reset(incoming);
+    collectRetiredModel();
+
+    model->reset_state();
 }
 
 void AmpModelProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& /*midiMessages*/)
@@ -59,33 +82,180 @@ void AmpModelProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::Mid
 
     const float * const * nn_input_read_ptr = nnInputBuffer.getArrayOfReadPointers();
     const float * const * nn_output_read_ptr = nnOutputBuffer.getArrayOfReadPointers();
+    const float * const * nn_fade_read_ptr = nnFadeBuffer.getArrayOfReadPointers();
     float * const * nn_input_write_ptr = nnInputBuffer.getArrayOfWritePointers();
     float * const * nn_output_write_ptr = nnOutputBuffer.getArrayOfWritePointers();
+    float * const * nn_fade_write_ptr = nnFadeBuffer.getArrayOfWritePointers();
     const float * const * audio_read_ptr = buffer.getArrayOfReadPointers();
     float * const * audio_write_ptr = buffer.getArrayOfWritePointers();
 
-    // first write input controls to nn_input_buffer
-    for (size_t i = 0; i < buffer.getNumSamples(); ++i)
+    const size_t num_channels = std::min(static_cast<size_t>(buffer.getNumChannels()), NUM_CHANNELS);
+    const size_t num_samples = static_cast<size_t>(buffer.getNumSamples());
+    if (num_channels == 0 || num_samples == 0)
+        return;
+
+    // both model channels always run, a mono input feeds the same signal to both
+    for (size_t ch = 0; ch < NUM_CHANNELS; ++ch)
+        oversamplingBuffer.copyFrom(static_cast<int>(ch), 0, audio_read_ptr[std::min(ch, num_channels - 1)], static_cast<int>(num_samples));
+
+    juce::dsp::AudioBlock<float> hostBlock(oversamplingBuffer.getArrayOfWritePointers(), NUM_CHANNELS, num_samples);
+    juce::dsp::AudioBlock<float> modelBlock { hostBlock };
+    if (oversamplingStages > 0)
+        modelBlock = oversamplers[oversamplingStages - 1]->processSamplesUp(hostBlock);
+
+    const size_t factor = size_t { 1 } << oversamplingStages;
+    const size_t num_model_samples = num_samples * factor;
+
+    parameterManager.processSmoothing(static_cast<int>(num_samples));
+    const float* volume_values = parameterManager.getSmoothedBuffer(volumeSmoothing);
+    const float* tone_values = parameterManager.getSmoothedBuffer(toneSmoothing);
+
+    // write audio and input controls of both channels to nn_input_buffer
+    // the controls are smoothed at the host rate and held over the oversampled frames
+    for (size_t i = 0; i < num_samples; ++i)
     {
-        nn_input_write_ptr[i][1] = volume.getNextValue();
-        nn_input_write_ptr[i][2] = tone.getNextValue();
+        // multiply by 0.8f because that's how it was trained
+        const float volume_value = volume_values[i] * 0.8f;
+        const float tone_value = tone_values[i] * 0.8f;
+        for (size_t k = i * factor; k < (i + 1) * factor; ++k)
+        {
+            for (size_t ch = 0; ch < NUM_CHANNELS; ++ch)
+            {
+                nn_input_write_ptr[k][ch * INPUT_SIZE + 0] = modelBlock.getSample(static_cast<int>(ch), static_cast<int>(k));
+                nn_input_write_ptr[k][ch * INPUT_SIZE + 1] = volume_value;
+                nn_input_write_ptr[k][ch * INPUT_SIZE + 2] = tone_value;
+            }
+        }
     }
 
-    for (size_t ch = 0; ch < std::min(buffer.getNumChannels(), 2); ++ch)
+    // process both channels in one pass
+    model->process(nn_output_write_ptr, nn_input_read_ptr, num_model_samples);
+
+    // take a pending model only once the last replaced one has been collected
+    GruModel* incoming { nullptr };
+    if (retiredModel.load(std::memory_order_acquire) == nullptr)
+        incoming = pendingModel.exchange(nullptr, std::memory_order_acquire);
+
+    if (incoming == nullptr)
     {
-        // initialise gru input with audio
-        for (size_t i = 0; i < buffer.getNumSamples(); ++i)
+        // copy gru output back to the model rate block
+        for (size_t ch = 0; ch < NUM_CHANNELS; ++ch)
         {
-            nn_input_write_ptr[i][0] = audio_read_ptr[ch][i];
+            float* model_write_ptr = modelBlock.getChannelPointer(ch);
+            for (size_t i = 0; i < num_model_samples; ++i)
+            {
+                model_write_ptr[i] = nn_output_read_ptr[i][ch * OUTPUT_SIZE];
+            }
         }
-        // process gru
-        gru[ch].process(nn_output_write_ptr, nn_input_read_ptr, buffer.getNumSamples());
-        // copy gru output to audio buffer
-        for (size_t i = 0; i < buffer.getNumSamples(); ++i)
+    }
+    else
+    {
+        // run the new model on the same input and crossfade to it over this block
+        incoming->process(nn_fade_write_ptr, nn_input_read_ptr, num_model_samples);
+
+        const float fadeStep = 1.f / static_cast<float>(num_model_samples);
+        for (size_t ch = 0; ch < NUM_CHANNELS; ++ch)
         {
-            audio_write_ptr[ch][i] = nn_output_read_ptr[i][0];
+            float* model_write_ptr = modelBlock.getChannelPointer(ch);
+            for (size_t i = 0; i < num_model_samples; ++i)
+            {
+                const float fade = static_cast<float>(i + 1) * fadeStep;
+                const float oldOutput = nn_output_read_ptr[i][ch * OUTPUT_SIZE];
+                const float newOutput = nn_fade_read_ptr[i][ch * OUTPUT_SIZE];
+                model_write_ptr[i] = oldOutput + fade * (newOutput - oldOutput);
+            }
         }
+
+        retiredModel.store(model.release(), std::memory_order_release);
+        model.reset(incoming);
     }
+
+    if (oversamplingStages > 0)
+        oversamplers[oversamplingStages - 1]->processSamplesDown(hostBlock);
+
+    for (size_t ch = 0; ch < num_channels; ++ch)
+        std::copy(hostBlock.getChannelPointer(ch), hostBlock.getChannelPointer(ch) + num_samples, audio_write_ptr[ch]);
+}
+
+void AmpModelProcessor::loadModelAsync(const juce::File& file, std::function<void(const juce::String& error)> onLoaded)
+{
+    modelLoader.addJob([this, file, onLoaded]
+    {
+        juce::String error;
+        std::unique_ptr<GruModel> newModel { GruModel::load(file, error) };
+        if (newModel != nullptr)
+        {
+            publishModel(std::move(newModel));
+
+            const juce::ScopedLock lock { modelStateLock };
+            modelPath = file.getFullPathName();
+        }
+
+        // Only the callback outlives the processor, not this
+        juce::MessageManager::callAsync([onLoaded, error] { if (onLoaded) onLoaded(error); });
+    });
+}
+
+bool AmpModelProcessor::exportDefaultModel(const juce::File& file, GruWeightType weightType) const
+{
+    return GruModel::save(file, GruParameterView::from_parameters(gruParameters.params), HIDDEN_SIZE, weightType);
+}
+
+void AmpModelProcessor::restoreModelAsync(const juce::String& path)
+{
+    modelLoader.addJob([this, path]
+    {
+        juce::String error;
+        std::unique_ptr<GruModel> newModel;
+        if (path.isNotEmpty())
+        {
+            const juce::File file { path };
+            if (file.existsAsFile())
+                newModel = GruModel::load(file, error);
+            else
+                error = "The model file " + path + " of this session was not found";
+        }
+
+        if (newModel == nullptr)
+            newModel = GruModel::create(GruParameterView::from_parameters(gruParameters.params), HIDDEN_SIZE);
+
+        publishModel(std::move(newModel));
+
+        if (error.isNotEmpty())
+            reportModelError(error + ", the built-in model is used instead");
+    });
+}
+
+void AmpModelProcessor::reportModelError(const juce::String& error)
+{
+    {
+        const juce::ScopedLock lock { modelStateLock };
+        modelError = error;
+    }
+
+    // Delivered on the message thread, also when an editor opens later through takeModelError
+    modelErrorBroadcaster.sendChangeMessage();
+}
+
+juce::String AmpModelProcessor::takeModelError()
+{
+    const juce::ScopedLock lock { modelStateLock };
+    juce::String error;
+    error.swapWith(modelError);
+    return error;
+}
+
+void AmpModelProcessor::publishModel(std::unique_ptr<GruModel> newModel)
+{
+    collectRetiredModel();
+
+    // A pending model the audio thread never picked up is replaced and freed here
+    delete pendingModel.exchange(newModel.release(), std::memory_order_acq_rel);
+}
+
+void AmpModelProcessor::collectRetiredModel()
+{
+    delete retiredModel.exchange(nullptr, std::memory_order_acq_rel);
 }
 
 void AmpModelProcessor::releaseResources()
@@ -94,12 +264,55 @@ void AmpModelProcessor::releaseResources()
 
 void AmpModelProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    parameterManager.getStateInformation(destData);
+    juce::MemoryBlock parameterState;
+    parameterManager.getStateInformation(parameterState);
+
+    destData.reset();
+    juce::MemoryOutputStream stream { destData, false };
+    stream.writeInt(StateMagic);
+    stream.writeInt(StateVersion);
+    stream.writeInt(static_cast<int>(parameterState.getSize()));
+    stream.write(parameterState.getData(), parameterState.getSize());
+
+    const juce::ScopedLock lock { modelStateLock };
+    stream.writeString(modelPath);
 }
 
 void AmpModelProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    parameterManager.setStateInformation(data, sizeInBytes);
+    if (data == nullptr || sizeInBytes <= 0)
+        return;
+
+    juce::MemoryInputStream stream { data, static_cast<size_t>(sizeInBytes), false };
+    juce::String path;
+    if (sizeInBytes >= 3 * static_cast<int>(sizeof(int)) && stream.readInt() == StateMagic)
+    {
+        if (stream.readInt() != StateVersion)
+            return;
+
+        const int parameterStateSize { stream.readInt() };
+        if (parameterStateSize < 0 || parameterStateSize > stream.getNumBytesRemaining())
+            return;
+
+        parameterManager.setStateInformation(static_cast<const char*>(data) + stream.getPosition(), parameterStateSize);
+        stream.skipNextBytes(parameterStateSize);
+        path = stream.readString();
+    }
+    else
+    {
+        parameterManager.setStateInformation(data, sizeInBytes);
+    }
+
+    {
+        // The model of the session is already running, e.g. the host restores the state it just saved
+        const juce::ScopedLock lock { modelStateLock };
+        if (path == modelPath)
+            return;
+
+        modelPath = path;
+    }
+
+    restoreModelAsync(path);
 }
 
 juce::AudioProcessorEditor* AmpModelProcessor::createEditor()
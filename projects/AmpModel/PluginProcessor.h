@@ -1,7 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Gru.h"
+#include "GruModel.h"
 #include "AmpGruParameters.h"
 
 namespace Param
@@ -10,12 +10,14 @@ namespace Param
     {
         static const juce::String Volume { "volume" };
         static const juce::String Tone { "tone" };
+        static const juce::String Oversampling { "oversampling" };
     }
 
     namespace Name
     {
         static const juce::String Volume { "Volume" };
         static const juce::String Tone { "Tone" };
+        static const juce::String Oversampling { "Oversampling" };
     }
 }
 
@@ -34,6 +36,19 @@ public:
 
     mrta::ParameterManager& getParameterManager() { return parameterManager; }
 
+    // Load a model file on a background thread and crossfade to it on the next block
+    // onLoaded is called on the message thread with an empty string on success, or the error
+    void loadModelAsync(const juce::File& file, std::function<void(const juce::String& error)> onLoaded);
+
+    // Write the compiled in model to a model file, e.g. as a starting point for trained ones,
+    // with the recurrent weights quantized to the given type
+    bool exportDefaultModel(const juce::File& file, GruWeightType weightType = GruWeightType::Float32) const;
+
+    // Problem with the model file of a restored session, e.g. a missing file, empty once taken
+    // Listeners are notified on the message thread when one is reported
+    juce::String takeModelError();
+    juce::ChangeBroadcaster& getModelErrorBroadcaster() { return modelErrorBroadcaster; }
+
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override;
@@ -51,19 +66,55 @@ public:
 
 private:
     mrta::ParameterManager parameterManager;
-    juce::SmoothedValue<float> volume;
-    juce::SmoothedValue<float> tone;
+    int volumeSmoothing { -1 };
+    int toneSmoothing { -1 };
 
     juce::AudioBuffer<float> nnInputBuffer;
     juce::AudioBuffer<float> nnOutputBuffer;
+    juce::AudioBuffer<float> nnFadeBuffer;
+
+    // The model runs at 1x, 2x or 4x the host rate, oversamplers[stages - 1] handles 2^stages
+    static constexpr size_t MAX_OVERSAMPLING_STAGES { 2u };
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversamplers[MAX_OVERSAMPLING_STAGES];
+    juce::AudioBuffer<float> oversamplingBuffer;
+    size_t oversamplingStages { 0u };
+
+    static constexpr size_t INPUT_SIZE { GruModel::INPUT_SIZE };
+    static constexpr size_t OUTPUT_SIZE { GruModel::OUTPUT_SIZE };
+    static constexpr size_t HIDDEN_SIZE { 16u };
 
-    static const size_t INPUT_SIZE = 3u;
-    static const size_t OUTPUT_SIZE = 1u;
-    static const size_t HIDDEN_SIZE = 16u;
+    static constexpr size_t NUM_CHANNELS { GruModel::NUM_CHANNELS };
 
-    Gru<INPUT_SIZE, OUTPUT_SIZE, HIDDEN_SIZE> gru[2];
+    // Fast activations stay within 1e-4 of the exact ones, well below the model error
+    // Both channels run as one batch so the weights are traversed once per sample
+    // Owned by the audio thread, except in the constructor, prepareToPlay and the destructor
+    std::unique_ptr<GruModel> model;
+
+    // Hot-swap slots, the audio thread takes the pending model and hands the replaced one back as retired
+    // Only the audio thread stores a retired model, and only once the previous one has been collected,
+    // so the audio thread never frees a model
+    std::atomic<GruModel*> pendingModel { nullptr };
+    std::atomic<GruModel*> retiredModel { nullptr };
+
+    void publishModel(std::unique_ptr<GruModel> newModel);
+    void collectRetiredModel();
+
+    // Load the model file of a restored session, or the compiled in model if the path is empty
+    // A missing or invalid file falls back to the compiled in model and is reported
+    void restoreModelAsync(const juce::String& path);
+    void reportModelError(const juce::String& error);
+
+    // Path of the loaded model file, empty for the compiled in model, saved with the session
+    // A missing file keeps its path, so saving the session again does not lose it
+    juce::CriticalSection modelStateLock;
+    juce::String modelPath;
+    juce::String modelError;
+    juce::ChangeBroadcaster modelErrorBroadcaster;
 
     AmpGruParameters gruParameters;
 
+    // Declared last so pending load jobs finish before the rest of the processor is destroyed
+    juce::ThreadPool modelLoader { 1 };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AmpModelProcessor)
 };
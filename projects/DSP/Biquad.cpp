@@ -9,7 +9,7 @@ Biquad::Biquad(unsigned int maxNumSections, unsigned int maxNumChannels) :
     allocatedChannels { maxNumChannels },
     allocatedSections { maxNumSections },
     coeffs(allocatedSections * CoeffsPerSection, 0.f),
-    states(allocatedChannels * allocatedSections * StatesPerSection, 0.f)
+    states(getNumGroups(allocatedChannels) * ChannelsPerGroup * allocatedSections * StatesPerSection, 0.f)
 {
 }
 
@@ -29,7 +29,7 @@ void Biquad::clear()
 void Biquad::reallocateChannels(unsigned int maxNumChannels)
 {
     allocatedChannels = maxNumChannels;
-    states.resize(allocatedChannels * allocatedSections * StatesPerSection);
+    states.resize(getNumGroups(allocatedChannels) * ChannelsPerGroup * allocatedSections * StatesPerSection);
     std::fill(states.begin(), states.end(), 0.f);
 }
 
@@ -37,7 +37,7 @@ void Biquad::reallocateSections(unsigned int numSections)
 {
     allocatedSections = numSections;
     coeffs.resize(allocatedSections * CoeffsPerSection);
-    states.resize(allocatedChannels * allocatedSections * StatesPerSection);
+    states.resize(getNumGroups(allocatedChannels) * ChannelsPerGroup * allocatedSections * StatesPerSection);
     std::fill(coeffs.begin(), coeffs.end(), 0.f);
     std::fill(states.begin(), states.end(), 0.f);
 }
@@ -49,59 +49,134 @@ void Biquad::setSectionCoeffs(const std::array<float, CoeffsPerSection>& newSect
 }
 
 void Biquad::process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
+{
+    numChannels = std::min(numChannels, allocatedChannels);
+
+    // Full groups take the vectorised path
+    const unsigned int numGroups { numChannels / ChannelsPerGroup };
+    for (unsigned int g = 0; g < numGroups; ++g)
+        processGroup(output, input, g, numSamples);
+
+    // Remaining channels take the scalar path
+    for (unsigned int c = numGroups * ChannelsPerGroup; c < numChannels; ++c)
+        processChannel(output[c], input[c], c, numSamples);
+}
+
+void Biquad::process(float* output, const float* input, unsigned int numChannels)
 {
     numChannels = std::min(numChannels, allocatedChannels);
     for (unsigned int c = 0; c < numChannels; ++c)
+        processChannel(output + c, input + c, c, 1);
+}
+
+unsigned int Biquad::getNumGroups(unsigned int numChannels)
+{
+    return (numChannels + ChannelsPerGroup - 1) / ChannelsPerGroup;
+}
+
+unsigned int Biquad::getStateOffset(unsigned int channel, unsigned int section) const
+{
+    const unsigned int group { channel / ChannelsPerGroup };
+    const unsigned int lane { channel % ChannelsPerGroup };
+    return ((group * allocatedSections + section) * StatesPerSection) * ChannelsPerGroup + lane;
+}
+
+void Biquad::processGroup(float* const* output, const float* const* input, unsigned int group, unsigned int numSamples)
+{
+    const unsigned int firstChannel { group * ChannelsPerGroup };
+    float* groupStates { states.data() + group * allocatedSections * StatesPerSection * ChannelsPerGroup };
+
+    // Channel interleaved working buffer, each frame is one vector
+    alignas(16) float frames[ChunkSize * ChannelsPerGroup];
+
+    for (unsigned int start = 0; start < numSamples; start += ChunkSize)
     {
-        for (unsigned int n = 0; n < numSamples; ++n)
+        const unsigned int chunkSize { std::min(ChunkSize, numSamples - start) };
+
+        for (unsigned int n = 0; n < chunkSize; ++n)
+            for (unsigned int l = 0; l < ChannelsPerGroup; ++l)
+                frames[n * ChannelsPerGroup + l] = input[firstChannel + l][start + n];
+
+        // Run the whole chunk thru one section at a time so its states
+        // and coeffs stay in registers for the duration of the chunk
+        for (unsigned int s = 0; s < allocatedSections; ++s)
         {
-            float x { input[c][n] };
-            for (unsigned int s = 0; s < allocatedSections; ++s)
+            float* sectionStates { groupStates + s * StatesPerSection * ChannelsPerGroup };
+            const unsigned int coeffOffset { s * CoeffsPerSection };
+
+            const SIMD::Float4 b0 { SIMD::broadcast(coeffs[coeffOffset + 0]) };
+            const SIMD::Float4 b1 { SIMD::broadcast(coeffs[coeffOffset + 1]) };
+            const SIMD::Float4 b2 { SIMD::broadcast(coeffs[coeffOffset + 2]) };
+            const SIMD::Float4 a1 { SIMD::broadcast(coeffs[coeffOffset + 3]) };
+            const SIMD::Float4 a2 { SIMD::broadcast(coeffs[coeffOffset + 4]) };
+
+            SIMD::Float4 bz1 { SIMD::load(sectionStates + 0 * ChannelsPerGroup) };
+            SIMD::Float4 bz2 { SIMD::load(sectionStates + 1 * ChannelsPerGroup) };
+            SIMD::Float4 az1 { SIMD::load(sectionStates + 2 * ChannelsPerGroup) };
+            SIMD::Float4 az2 { SIMD::load(sectionStates + 3 * ChannelsPerGroup) };
+
+            for (unsigned int n = 0; n < chunkSize; ++n)
             {
-                const unsigned int stateOffset { c * allocatedSections * StatesPerSection + s * StatesPerSection };
-                const unsigned int coeffOffset { s * CoeffsPerSection };
-
-                float acc { x * coeffs[coeffOffset + 0] }; // b0
-                acc += coeffs[coeffOffset + 1] * states[stateOffset + 0]; // b1
-                acc += coeffs[coeffOffset + 2] * states[stateOffset + 1]; // b2
-                acc -= coeffs[coeffOffset + 3] * states[stateOffset + 2]; // a1
-                acc -= coeffs[coeffOffset + 4] * states[stateOffset + 3]; // a2
-
-                states[stateOffset + 1] = states[stateOffset + 0];
-                states[stateOffset + 0] = x;
-                states[stateOffset + 3] = states[stateOffset + 2];
-                states[stateOffset + 2] = acc;
-                x = acc;
+                const SIMD::Float4 x { SIMD::load(frames + n * ChannelsPerGroup) };
+
+                // Same operation order as the scalar path
+                SIMD::Float4 acc { x * b0 };
+                acc = acc + b1 * bz1;
+                acc = acc + b2 * bz2;
+                acc = acc - a1 * az1;
+                acc = acc - a2 * az2;
+
+                bz2 = bz1;
+                bz1 = x;
+                az2 = az1;
+                az1 = acc;
+
+                SIMD::store(frames + n * ChannelsPerGroup, acc);
             }
-            output[c][n] = x;
+
+            SIMD::store(sectionStates + 0 * ChannelsPerGroup, bz1);
+            SIMD::store(sectionStates + 1 * ChannelsPerGroup, bz2);
+            SIMD::store(sectionStates + 2 * ChannelsPerGroup, az1);
+            SIMD::store(sectionStates + 3 * ChannelsPerGroup, az2);
         }
+
+        for (unsigned int n = 0; n < chunkSize; ++n)
+            for (unsigned int l = 0; l < ChannelsPerGroup; ++l)
+                output[firstChannel + l][start + n] = frames[n * ChannelsPerGroup + l];
     }
 }
 
-void Biquad::process(float* output, const float* input, unsigned int numChannels)
+void Biquad::processChannel(float* output, const float* input, unsigned int channel, unsigned int numSamples)
 {
-    numChannels = std::min(numChannels, allocatedChannels);
-    for (unsigned int c = 0; c < numChannels; ++c)
+    float* channelStates { states.data() + getStateOffset(channel, 0) };
+    const float* sectionCoeffs { coeffs.data() };
+
+    for (unsigned int n = 0; n < numSamples; ++n)
     {
-        float x { input[c] };
+        float x { input[n] };
         for (unsigned int s = 0; s < allocatedSections; ++s)
         {
-            const unsigned int stateOffset { c * allocatedSections * StatesPerSection + s * StatesPerSection };
+            const unsigned int stateOffset { s * StatesPerSection * ChannelsPerGroup };
             const unsigned int coeffOffset { s * CoeffsPerSection };
 
-            float acc { x * coeffs[coeffOffset + 0] }; // b0
-            acc += coeffs[coeffOffset + 1] * states[stateOffset + 0]; // b1
-            acc += coeffs[coeffOffset + 2] * states[stateOffset + 1]; // b2
-            acc -= coeffs[coeffOffset + 3] * states[stateOffset + 2]; // a1
-            acc -= coeffs[coeffOffset + 4] * states[stateOffset + 3]; // a2
-
-            states[stateOffset + 1] = states[stateOffset + 0];
-            states[stateOffset + 0] = x;
-            states[stateOffset + 3] = states[stateOffset + 2];
-            states[stateOffset + 2] = acc;
+            float& bz1 { channelStates[stateOffset + 0 * ChannelsPerGroup] };
+            float& bz2 { channelStates[stateOffset + 1 * ChannelsPerGroup] };
+            float& az1 { channelStates[stateOffset + 2 * ChannelsPerGroup] };
+            float& az2 { channelStates[stateOffset + 3 * ChannelsPerGroup] };
+
+            float acc { x * sectionCoeffs[coeffOffset + 0] }; // b0
+            acc += sectionCoeffs[coeffOffset + 1] * bz1; // b1
+            acc += sectionCoeffs[coeffOffset + 2] * bz2; // b2
+            acc -= sectionCoeffs[coeffOffset + 3] * az1; // a1
+            acc -= sectionCoeffs[coeffOffset + 4] * az2; // a2
+
+            bz2 = bz1;
+            bz1 = x;
+            az2 = az1;
+            az1 = acc;
             x = acc;
         }
-        output[c] = x;
+        output[n] = x;
     }
 }
 
@@ -3,6 +3,8 @@
 #include <array>
 #include <vector>
 
+#include "SIMD.h"
+
 namespace DSP
 {
 
@@ -22,6 +24,9 @@ public:
     static const unsigned int CoeffsPerSection = 5;
     static const unsigned int StatesPerSection = 4;
 
+    // Number of channels processed together by the vectorised path
+    static const unsigned int ChannelsPerGroup = SIMD::Float4::Size;
+
     // Clear all states
     void clear();
 
@@ -38,6 +43,8 @@ public:
 
     // Process audio
     // This method can be called with a lower number of channels than allocated
+    // Every full group of ChannelsPerGroup channels is processed by the vectorised
+    // path, any remaining channels fall back to the scalar path
     void process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples);
 
     // Process audio
@@ -58,10 +65,28 @@ private:
     // [sos0_b0, sos0_b1, sos0_b2, sos0_a1, sos0_a2, sos1_b0, sos1_b1, ...]
     std::vector<float> coeffs;
 
-    // vector of states of all channels and sections
-    // [ch0_sos0_bz1, ... , ch0_sos0_az2, ch0_sos1_bz1, ... , ch0_sos1_az2, ... ,
-    //  ch1_sos0_bz1, ... , ch1_sos0_az2, ch1_sos1_bz1, ... , ch1_sos1_az2, ...]
+    // vector of states of all channels and sections, channels are grouped
+    // and interleaved so each state of a group can be loaded as a single vector
+    // [grp0_sos0_bz1_ch0, ... , grp0_sos0_bz1_ch3, grp0_sos0_bz2_ch0, ... , grp0_sos0_az2_ch3,
+    //  grp0_sos1_bz1_ch0, ... , grp0_sos1_az2_ch3, ... ,
+    //  grp1_sos0_bz1_ch4, ... , grp1_sos0_az2_ch7, grp1_sos1_bz1_ch4, ... ]
     std::vector<float> states;
+
+    // Number of samples handled per chunk by the vectorised path
+    static const unsigned int ChunkSize = 32;
+
+    // Number of channel groups needed to hold a channel count
+    static unsigned int getNumGroups(unsigned int numChannels);
+
+    // Offset of the first state of a channel section
+    // consecutive states of the same channel are ChannelsPerGroup apart
+    unsigned int getStateOffset(unsigned int channel, unsigned int section) const;
+
+    // Vectorised path, processes ChannelsPerGroup channels starting at group * ChannelsPerGroup
+    void processGroup(float* const* output, const float* const* input, unsigned int group, unsigned int numSamples);
+
+    // Scalar path, processes a single channel
+    void processChannel(float* output, const float* input, unsigned int channel, unsigned int numSamples);
 };
 
 }
\ No newline at end of file
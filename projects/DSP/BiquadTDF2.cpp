@@ -0,0 +1,190 @@
+#include "BiquadTDF2.h"
+
+#include <algorithm>
+
+namespace DSP
+{
+
+BiquadTDF2::BiquadTDF2(unsigned int maxNumSections, unsigned int maxNumChannels) :
+    allocatedChannels { maxNumChannels },
+    allocatedSections { maxNumSections },
+    coeffRamps(std::make_unique<DSP::Ramp<float>[]>(allocatedSections * CoeffsPerSection)),
+    coeffs(allocatedSections * CoeffsPerSection, 0.f),
+    coeffIncs(allocatedSections * CoeffsPerSection, 0.f),
+    states(allocatedChannels * allocatedSections * StatesPerSection, 0.f)
+{
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+        coeffRamps[i].setRampTime(rampTime);
+}
+
+BiquadTDF2::BiquadTDF2()
+{
+}
+
+BiquadTDF2::~BiquadTDF2()
+{
+}
+
+void BiquadTDF2::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+    {
+        coeffRamps[i].prepare(sampleRate, true, coeffRamps[i].getTarget());
+        coeffs[i] = coeffRamps[i].getCurrent();
+        coeffIncs[i] = 0.f;
+    }
+}
+
+void BiquadTDF2::clear()
+{
+    std::fill(states.begin(), states.end(), 0.f);
+}
+
+void BiquadTDF2::reallocateChannels(unsigned int maxNumChannels)
+{
+    allocatedChannels = maxNumChannels;
+    states.resize(allocatedChannels * allocatedSections * StatesPerSection);
+    std::fill(states.begin(), states.end(), 0.f);
+}
+
+void BiquadTDF2::reallocateSections(unsigned int numSections)
+{
+    allocatedSections = numSections;
+
+    coeffRamps = std::make_unique<DSP::Ramp<float>[]>(allocatedSections * CoeffsPerSection);
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+    {
+        coeffRamps[i].setRampTime(rampTime);
+        coeffRamps[i].prepare(sampleRate, true, 0.f);
+    }
+
+    coeffs.resize(allocatedSections * CoeffsPerSection);
+    coeffIncs.resize(allocatedSections * CoeffsPerSection);
+    states.resize(allocatedChannels * allocatedSections * StatesPerSection);
+    std::fill(coeffs.begin(), coeffs.end(), 0.f);
+    std::fill(coeffIncs.begin(), coeffIncs.end(), 0.f);
+    std::fill(states.begin(), states.end(), 0.f);
+}
+
+void BiquadTDF2::setSectionCoeffs(const std::array<float, CoeffsPerSection>& newSectionCoeffs, unsigned int section, bool skipRamp)
+{
+    if (section < allocatedSections)
+    {
+        const unsigned int coeffOffset { section * CoeffsPerSection };
+        for (unsigned int i = 0; i < CoeffsPerSection; ++i)
+        {
+            coeffRamps[coeffOffset + i].setTarget(newSectionCoeffs[i], skipRamp);
+            if (skipRamp)
+                coeffs[coeffOffset + i] = newSectionCoeffs[i];
+        }
+    }
+}
+
+void BiquadTDF2::setRampTime(float newRampTimeSec)
+{
+    rampTime = newRampTimeSec;
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+        coeffRamps[i].setRampTime(rampTime);
+}
+
+void BiquadTDF2::process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
+{
+    if (numSamples == 0)
+        return;
+
+    advanceCoeffs(numSamples);
+
+    numChannels = std::min(numChannels, allocatedChannels);
+    for (unsigned int c = 0; c < numChannels; ++c)
+    {
+        // Run the whole block thru one section at a time, the first section
+        // reads from the input and the following ones work in-place on the output
+        const float* x { input[c] };
+        float* y { output[c] };
+
+        for (unsigned int s = 0; s < allocatedSections; ++s)
+        {
+            const unsigned int stateOffset { c * allocatedSections * StatesPerSection + s * StatesPerSection };
+            const unsigned int coeffOffset { s * CoeffsPerSection };
+
+            float b0 { coeffs[coeffOffset + 0] };
+            float b1 { coeffs[coeffOffset + 1] };
+            float b2 { coeffs[coeffOffset + 2] };
+            float a1 { coeffs[coeffOffset + 3] };
+            float a2 { coeffs[coeffOffset + 4] };
+
+            const float b0Inc { coeffIncs[coeffOffset + 0] };
+            const float b1Inc { coeffIncs[coeffOffset + 1] };
+            const float b2Inc { coeffIncs[coeffOffset + 2] };
+            const float a1Inc { coeffIncs[coeffOffset + 3] };
+            const float a2Inc { coeffIncs[coeffOffset + 4] };
+
+            float z1 { states[stateOffset + 0] };
+            float z2 { states[stateOffset + 1] };
+
+            for (unsigned int n = 0; n < numSamples; ++n)
+            {
+                b0 += b0Inc; b1 += b1Inc; b2 += b2Inc;
+                a1 += a1Inc; a2 += a2Inc;
+
+                const float in { x[n] };
+                const float out { b0 * in + z1 };
+                z1 = b1 * in - a1 * out + z2;
+                z2 = b2 * in - a2 * out;
+                y[n] = out;
+            }
+
+            states[stateOffset + 0] = z1;
+            states[stateOffset + 1] = z2;
+
+            x = y;
+        }
+
+        if (allocatedSections == 0 && output[c] != input[c])
+            std::copy(input[c], input[c] + numSamples, output[c]);
+    }
+
+    // Next block starts where this one ended
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+        coeffs[i] = coeffRamps[i].getCurrent();
+}
+
+void BiquadTDF2::process(float* output, const float* input, unsigned int numChannels)
+{
+    advanceCoeffs(1);
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+        coeffs[i] = coeffRamps[i].getCurrent();
+
+    numChannels = std::min(numChannels, allocatedChannels);
+    for (unsigned int c = 0; c < numChannels; ++c)
+    {
+        float x { input[c] };
+        for (unsigned int s = 0; s < allocatedSections; ++s)
+        {
+            const unsigned int stateOffset { c * allocatedSections * StatesPerSection + s * StatesPerSection };
+            const unsigned int coeffOffset { s * CoeffsPerSection };
+
+            const float y { coeffs[coeffOffset + 0] * x + states[stateOffset + 0] }; // b0
+            states[stateOffset + 0] = coeffs[coeffOffset + 1] * x - coeffs[coeffOffset + 3] * y + states[stateOffset + 1]; // b1, a1
+            states[stateOffset + 1] = coeffs[coeffOffset + 2] * x - coeffs[coeffOffset + 4] * y; // b2, a2
+            x = y;
+        }
+        output[c] = x;
+    }
+}
+
+void BiquadTDF2::advanceCoeffs(unsigned int numSamples)
+{
+    const float invNumSamples { 1.f / static_cast<float>(numSamples) };
+    for (unsigned int i = 0; i < allocatedSections * CoeffsPerSection; ++i)
+    {
+        const float start { coeffRamps[i].getCurrent() };
+        const float end { coeffRamps[i].skip(numSamples) };
+        coeffs[i] = start;
+        coeffIncs[i] = (end - start) * invNumSamples;
+    }
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "Ramp.h"
+
+namespace DSP
+{
+
+// Biquad cascade realised in Transposed Direct Form II
+// Uses two states per section instead of four and ramps every coefficient
+// towards its target, so coefficient updates are free of clicks and zipper noise
+// The ramps are evaluated once per processed block and the coefficients are
+// linearly interpolated between the block edges
+class BiquadTDF2
+{
+public:
+    BiquadTDF2(unsigned int numSections, unsigned int maxNumChannels);
+    BiquadTDF2();
+    ~BiquadTDF2();
+
+    // No copy semantics
+    BiquadTDF2(const BiquadTDF2&) = delete;
+    const BiquadTDF2& operator=(const BiquadTDF2&) = delete;
+
+    // No move semantics
+    BiquadTDF2(BiquadTDF2&&) = delete;
+    const BiquadTDF2& operator=(BiquadTDF2&&) = delete;
+
+    static const unsigned int CoeffsPerSection = 5;
+    static const unsigned int StatesPerSection = 2;
+
+    // Default coefficient ramp time of 20ms
+    static constexpr float DefaultRampTime { 0.02f };
+
+    // Update the sample rate of the coefficient ramps
+    // Calling this method will skip all coefficients to their targets
+    void prepare(double sampleRate);
+
+    // Clear all states
+    void clear();
+
+    // Reallocate state storage
+    // Calling this method will clear the states
+    void reallocateChannels(unsigned int maxNumChannels);
+
+    // Reallocate coefficient and state storage
+    // Calling this method will clear the coefficients and states
+    void reallocateSections(unsigned int numSections);
+
+    // Set new target coeffs to a section, optionally skipping the ramp
+    void setSectionCoeffs(const std::array<float, CoeffsPerSection>& newSectionCoeffs, unsigned int section, bool skipRamp = false);
+
+    // Set the coefficient ramp time in seconds
+    void setRampTime(float rampTimeSec);
+
+    // Process audio
+    // This method can be called with a lower number of channels than allocated
+    void process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples);
+
+    // Process audio
+    // Single sample flavour
+    void process(float* output, const float* input, unsigned int numChannels);
+
+    // return the number of currently allocated channels
+    unsigned int getAllocatedChannels() const noexcept { return allocatedChannels; }
+
+    // return the number of currently allocated sections
+    unsigned int getAllocatedSections() const noexcept { return allocatedSections; }
+
+private:
+    double sampleRate { 48000.0 };
+    float rampTime { DefaultRampTime };
+
+    unsigned int allocatedChannels { 0 };
+    unsigned int allocatedSections { 0 };
+
+    // one ramp per coefficient of all sections
+    // [sos0_b0, sos0_b1, sos0_b2, sos0_a1, sos0_a2, sos1_b0, sos1_b1, ...]
+    std::unique_ptr<DSP::Ramp<float>[]> coeffRamps;
+
+    // coefficients at the start of the current block and their per sample increments
+    // same layout as the ramps
+    std::vector<float> coeffs;
+    std::vector<float> coeffIncs;
+
+    // vector of states of all channels and sections
+    // [ch0_sos0_z1, ch0_sos0_z2, ch0_sos1_z1, ch0_sos1_z2, ... ,
+    //  ch1_sos0_z1, ch1_sos0_z2, ch1_sos1_z1, ch1_sos1_z2, ...]
+    std::vector<float> states;
+
+    // Advance the coefficient ramps by a block and update the interpolation increments
+    void advanceCoeffs(unsigned int numSamples);
+};
+
+}
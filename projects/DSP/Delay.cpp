@@ -7,8 +7,8 @@ namespace DSP
 {
 
 Delay::Delay(float maxTimeMs, unsigned int numChannels) :
-    delayLine(static_cast<unsigned int>(std::ceil(std::fmax(maxTimeMs, 1.f) * static_cast<float>(0.001 * sampleRate))), numChannels),
-    filter(1),
+    delayLine(static_cast<unsigned int>(std::ceil(std::fmax(maxTimeMs, 1.f) * static_cast<float>(0.001 * sampleRate))), numChannels, true),
+    filter(1, 2, ParametricEqualizer::TransposedDirectForm2),
     preDistortionRamp(0.02f),
     postDistortionRamp(0.02f),
     timeRamp(0.5f),
@@ -25,7 +25,7 @@ void Delay::prepare(double newSampleRate, float maxTimeMs, unsigned int numChann
 {
     sampleRate = newSampleRate;
 
-    delayLine.prepare(static_cast<unsigned int>(std::round(maxTimeMs * static_cast<float>(0.001 * sampleRate))), MaxChannels);
+    delayLine.prepare(static_cast<unsigned int>(std::round(maxTimeMs * static_cast<float>(0.001 * sampleRate))), MaxChannels, true);
     delayLine.setDelaySamples(1); // Keep at least 1 sample minimum fixed delay
 
     filter.setBandType(0, ParametricEqualizer::LowPass);
@@ -58,50 +58,87 @@ void Delay::clear()
 
 void Delay::process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
 {
-    for (unsigned int n = 0; n < numSamples; ++n)
-    {
-        // Process LFO acording to mod type
-        float lfo[2] { 0.f, 0.f };
+    numChannels = std::min(numChannels, static_cast<unsigned int>(MaxChannels));
+
+    float* mod[2] { modBuffer[0], modBuffer[1] };
+    float* delayIn[2] { delayInBuffer[0], delayInBuffer[1] };
+    float* delayOut[2] { delayOutBuffer[0], delayOutBuffer[1] };
 
-        // squared sine modulation
-        const auto lfo_left { 0.5f + 0.5f * std::sin(phaseState[0]) };
-        const auto lfo_right { 0.5f + 0.5f * std::sin(phaseState[1]) };
-        lfo[0] = lfo_left * lfo_left;
-        lfo[1] = lfo_right * lfo_right;
+    const float twoPi { static_cast<float>(2.0 * M_PI) };
+    const float rotCos { std::cos(phaseInc) };
+    const float rotSin { std::sin(phaseInc) };
 
-        // Increment and wrap phase states
-        phaseState[0] = std::fmod(phaseState[0] + phaseInc, static_cast<float>(2 * M_PI));
-        phaseState[1] = std::fmod(phaseState[1] + phaseInc, static_cast<float>(2 * M_PI));
+    for (unsigned int offset = 0; offset < numSamples;)
+    {
+        // The block must be shorter than the shortest delay within it, so every
+        // delayed sample is read before the feedback of this block is written
+        // The time ramp is monotonic and the wow only adds to it, and the
+        // delay line adds its one sample fixed delay
+        const float minDelay { 1.f + std::fmin(timeRamp.getCurrent(), timeRamp.getTarget()) };
+        const unsigned int maxBlockSize { std::max(static_cast<unsigned int>(minDelay), 1u) };
+        const unsigned int blockSize { std::min({ BlockSize, maxBlockSize, numSamples - offset }) };
+
+        // Squared sine modulation, rotating a phasor instead of calling sin every sample
+        for (unsigned int ch = 0; ch < 2; ++ch)
+        {
+            float re { std::cos(phaseState[ch]) };
+            float im { std::sin(phaseState[ch]) };
+            for (unsigned int n = 0; n < blockSize; ++n)
+            {
+                const float lfo { 0.5f + 0.5f * im };
+                mod[ch][n] = lfo * lfo;
+
+                const float nextRe { re * rotCos - im * rotSin };
+                im = re * rotSin + im * rotCos;
+                re = nextRe;
+            }
+
+            phaseState[ch] = std::fmod(phaseState[ch] + static_cast<float>(blockSize) * phaseInc, twoPi);
+        }
 
         // Apply wow and time ramps
-        wowRamp.applyGain(lfo, numChannels);
-        timeRamp.applySum(lfo, numChannels);
+        wowRamp.applyGain(mod, numChannels, blockSize);
+        timeRamp.applySum(mod, numChannels, blockSize);
+
+        // Read the delayed block
+        delayLine.read(delayOut, mod, numChannels, blockSize);
+
+        // Feedback is the delay output one sample earlier
+        for (unsigned int ch = 0; ch < numChannels; ++ch)
+        {
+            delayIn[ch][0] = feedbackState[ch];
+            std::copy(delayOut[ch], delayOut[ch] + blockSize - 1, delayIn[ch] + 1);
+        }
 
         // Apply feedback ramp
-        feedbackRamp.applyGain(feedbackState, numChannels);
+        feedbackRamp.applyGain(delayIn, numChannels, blockSize);
 
         // Sum feedback
-        float delayIn[2] { 0.f, 0.f };
         for (unsigned int ch = 0; ch < numChannels; ++ch)
-            delayIn[ch] = input[ch][n] + feedbackState[ch];
+            for (unsigned int n = 0; n < blockSize; ++n)
+                delayIn[ch][n] += input[ch][offset + n];
 
         // Apply distortion
-        preDistortionRamp.applyGain(delayIn, numChannels);
-        float delayInDistortion[2];
+        preDistortionRamp.applyGain(delayIn, numChannels, blockSize);
         for (unsigned int ch = 0; ch < numChannels; ++ch)
-            delayInDistortion[ch] = std::tanh(delayIn[ch]);
-        postDistortionRamp.applyGain(delayInDistortion, numChannels);
+            for (unsigned int n = 0; n < blockSize; ++n)
+                delayIn[ch][n] = std::tanh(delayIn[ch][n]);
+        postDistortionRamp.applyGain(delayIn, numChannels, blockSize);
 
         // Apply tone filter
-        float delayInDistortionFilter[2] { 0.f, 0.f };
-        filter.process(delayInDistortionFilter, delayInDistortion, numChannels);
+        filter.process(delayIn, delayIn, numChannels, blockSize);
 
-        // Process delay
-        delayLine.process(feedbackState, delayInDistortionFilter, lfo, numChannels);
+        // Write the delay input
+        delayLine.write(delayIn, numChannels, blockSize);
 
         // Write to output buffers
         for (unsigned int ch = 0; ch < numChannels; ++ch)
-            output[ch][n] = feedbackState[ch];
+        {
+            std::copy(delayOut[ch], delayOut[ch] + blockSize, output[ch] + offset);
+            feedbackState[ch] = delayOut[ch][blockSize - 1];
+        }
+
+        offset += blockSize;
     }
 }
 
@@ -70,6 +70,14 @@ private:
     float toneFrequency { 5000.f };
     float distortion { 0.f };
 
+    // Longest internal processing block, shorter blocks are used when
+    // the delay time is shorter so the feedback loop stays sample accurate
+    static constexpr unsigned int BlockSize { 64 };
+
+    float modBuffer[2][BlockSize];
+    float delayInBuffer[2][BlockSize];
+    float delayOutBuffer[2][BlockSize];
+
     static constexpr float WowFreqHz { 2.f };
     static constexpr float WowDepthMax { 0.002f };
     static constexpr float MaxChannels { 2 };
@@ -2,14 +2,75 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 
 namespace DSP
 {
 
-DelayLine::DelayLine(unsigned int maxLengthSamples, unsigned int numChannels)
+namespace
 {
-    for (unsigned int ch = 0; ch < numChannels; ++ch)
-        delayBuffer.emplace_back(maxLengthSamples, 0.f);
+
+// Polyphase Blackman windowed sinc kernels, one row per fractional delay step
+// Every row is normalised to unity gain at DC
+struct SincTable
+{
+    static constexpr unsigned int Taps { 8 };
+    static constexpr unsigned int HalfTaps { Taps / 2 };
+    static constexpr unsigned int Phases { 256 };
+
+    // One extra row so the last phase can be blended with the next
+    float coeffs[Phases + 1][Taps];
+
+    SincTable()
+    {
+        const double pi { M_PI };
+        for (unsigned int p = 0; p <= Phases; ++p)
+        {
+            const double frac { static_cast<double>(p) / static_cast<double>(Phases) };
+
+            double sum { 0.0 };
+            for (unsigned int t = 0; t < Taps; ++t)
+            {
+                // Distance from the tap to the fractional read position
+                const double x { static_cast<double>(t) - static_cast<double>(HalfTaps - 1) - frac };
+                const double sinc { std::fabs(x) < 1e-9 ? 1.0 : std::sin(pi * x) / (pi * x) };
+                const double w { 0.42 + 0.5 * std::cos(pi * x / HalfTaps) + 0.08 * std::cos(2.0 * pi * x / HalfTaps) };
+                coeffs[p][t] = static_cast<float>(sinc * w);
+                sum += sinc * w;
+            }
+
+            for (unsigned int t = 0; t < Taps; ++t)
+                coeffs[p][t] = static_cast<float>(coeffs[p][t] / sum);
+        }
+    }
+};
+
+// First order Thiran allpass coefficients for fractional delays in [0.5, 1.5]
+struct AllpassTable
+{
+    static constexpr unsigned int Size { 1024 };
+
+    float coeffs[Size + 1];
+
+    AllpassTable()
+    {
+        for (unsigned int i = 0; i <= Size; ++i)
+        {
+            const double delta { 0.5 + static_cast<double>(i) / static_cast<double>(Size) };
+            coeffs[i] = static_cast<float>((1.0 - delta) / (1.0 + delta));
+        }
+    }
+};
+
+// Computed once when the plugin is loaded, shared by all instances
+const SincTable sincTable;
+const AllpassTable allpassTable;
+
+}
+
+DelayLine::DelayLine(unsigned int maxLengthSamples, unsigned int numChannels, bool roundToPowerOfTwo)
+{
+    allocate(maxLengthSamples, numChannels, roundToPowerOfTwo);
 }
 
 DelayLine::~DelayLine()
@@ -20,47 +81,71 @@ void DelayLine::clear()
 {
     for (auto& b : delayBuffer)
         std::fill(b.begin(), b.end(), 0.f);
+
+    std::fill(allpassStates.begin(), allpassStates.end(), 0.f);
 }
 
-void DelayLine::prepare(unsigned int maxLengthSamples, unsigned int numChannels)
+void DelayLine::prepare(unsigned int maxLengthSamples, unsigned int numChannels, bool roundToPowerOfTwo)
 {
-    delayBuffer.clear();
-    for (unsigned int ch = 0; ch < numChannels; ++ch)
-        delayBuffer.emplace_back(maxLengthSamples, 0.f);
+    allocate(maxLengthSamples, numChannels, roundToPowerOfTwo);
+
+    // Keep indices valid for the new buffer size
+    writeIndex = 0;
+    delaySamples = std::min(delaySamples, bufferSize - 1u);
 }
 
 void DelayLine::process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
 {
-    const unsigned int delayBufferSize { static_cast<unsigned int>(delayBuffer[0].size()) };
+    // Largest chunk for which the read and write regions never overlap,
+    // so a chunk can be written as a whole and then read as a whole
+    const unsigned int maxChunkSize { std::min(delaySamples, bufferSize - delaySamples) };
 
     numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
     for (unsigned int ch = 0; ch < numChannels; ++ch)
     {
         unsigned int workingWriteIndex { writeIndex };
-        unsigned int workingReadIndex { (workingWriteIndex + delayBufferSize - delaySamples) % delayBufferSize };
 
-        for (unsigned int n = 0; n < numSamples; ++n)
+        if (maxChunkSize < MinSpanSize)
         {
-            const float x { input[ch][n] };
-            output[ch][n] = delayBuffer[ch][workingReadIndex];
-            delayBuffer[ch][workingWriteIndex] = x;
-
-            ++workingWriteIndex; workingWriteIndex %= delayBufferSize;
-            ++workingReadIndex; workingReadIndex %= delayBufferSize;
+            // Very short (or very long) delay, go sample by sample
+            unsigned int workingReadIndex { wrap(workingWriteIndex + bufferSize - delaySamples) };
+
+            for (unsigned int n = 0; n < numSamples; ++n)
+            {
+                const float x { input[ch][n] };
+                output[ch][n] = delayBuffer[ch][workingReadIndex];
+                delayBuffer[ch][workingWriteIndex] = x;
+
+                workingWriteIndex = wrap(workingWriteIndex + 1u);
+                workingReadIndex = wrap(workingReadIndex + 1u);
+            }
+        }
+        else
+        {
+            for (unsigned int n = 0; n < numSamples;)
+            {
+                const unsigned int chunkSize { std::min(maxChunkSize, numSamples - n) };
+                const unsigned int workingReadIndex { wrap(workingWriteIndex + bufferSize - delaySamples) };
+
+                // Write before read, so in-place processing does not overwrite the input
+                writeSpan(ch, workingWriteIndex, input[ch] + n, chunkSize);
+                readSpan(ch, workingReadIndex, output[ch] + n, chunkSize);
+
+                workingWriteIndex = wrap(workingWriteIndex + chunkSize);
+                n += chunkSize;
+            }
         }
     }
 
-    writeIndex += numSamples; writeIndex %= delayBufferSize;
+    writeIndex = (writeIndex + numSamples) % bufferSize;
 }
 
 void DelayLine::process(float* output, const float* input, unsigned int numChannels)
 {
-    const unsigned int delayBufferSize{ static_cast<unsigned int>(delayBuffer[0].size()) };
-
     numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
 
-    unsigned int workingWriteIndex { writeIndex };
-    unsigned int workingReadIndex { (workingWriteIndex + delayBufferSize - delaySamples) % delayBufferSize };
+    const unsigned int workingWriteIndex { writeIndex };
+    const unsigned int workingReadIndex { wrap(workingWriteIndex + bufferSize - delaySamples) };
 
     for (unsigned int ch = 0; ch < numChannels; ++ch)
     {
@@ -69,98 +154,310 @@ void DelayLine::process(float* output, const float* input, unsigned int numChann
         delayBuffer[ch][workingWriteIndex] = x;
     }
 
-    ++writeIndex; writeIndex %= delayBufferSize;
+    writeIndex = wrap(writeIndex + 1u);
 }
 
 void DelayLine::process(float* const* audioOutput, const float* const* audioInput, const float* const* modInput, unsigned int numChannels, unsigned int numSamples)
 {
-    const unsigned int delayBufferSize{ static_cast<unsigned int>(delayBuffer[0].size()) };
+    // Dispatch once per block so the sample loops are specialised for each interpolation
+    switch (interpolationType)
+    {
+    case Lagrange3:
+        processModulated<Lagrange3>(audioOutput, audioInput, modInput, numChannels, numSamples);
+        break;
+
+    case Allpass:
+        processModulated<Allpass>(audioOutput, audioInput, modInput, numChannels, numSamples);
+        break;
+
+    case Sinc:
+        processModulated<Sinc>(audioOutput, audioInput, modInput, numChannels, numSamples);
+        break;
+
+    case Linear:
+    default:
+        processModulated<Linear>(audioOutput, audioInput, modInput, numChannels, numSamples);
+        break;
+    }
+}
 
+void DelayLine::process(float* audioOutput, const float* audioInput, const float* modInput, unsigned int numChannels)
+{
+    numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
+    for (unsigned int ch = 0; ch < numChannels; ++ch)
+    {
+        const float delay { static_cast<float>(delaySamples) + modInput[ch] };
+
+        // Write input first, a delay of zero is the current input sample
+        delayBuffer[ch][writeIndex] = audioInput[ch];
+
+        switch (interpolationType)
+        {
+        case Lagrange3: audioOutput[ch] = readInterpolated<Lagrange3>(ch, writeIndex, delay); break;
+        case Allpass: audioOutput[ch] = readInterpolated<Allpass>(ch, writeIndex, delay); break;
+        case Sinc: audioOutput[ch] = readInterpolated<Sinc>(ch, writeIndex, delay); break;
+        case Linear:
+        default: audioOutput[ch] = readInterpolated<Linear>(ch, writeIndex, delay); break;
+        }
+    }
+
+    // Update persistent write index
+    writeIndex = wrap(writeIndex + 1u);
+}
+
+void DelayLine::processTaps(float* const* output, const float* const* input, const Tap* taps, unsigned int numTaps, unsigned int numChannels, unsigned int numSamples)
+{
+    switch (interpolationType)
+    {
+    case Lagrange3:
+        processTapsInterpolated<Lagrange3>(output, input, taps, numTaps, numChannels, numSamples);
+        break;
+
+    case Sinc:
+        processTapsInterpolated<Sinc>(output, input, taps, numTaps, numChannels, numSamples);
+        break;
+
+    case Linear:
+    case Allpass:
+    default:
+        processTapsInterpolated<Linear>(output, input, taps, numTaps, numChannels, numSamples);
+        break;
+    }
+}
+
+void DelayLine::read(float* const* output, const float* const* modInput, unsigned int numChannels, unsigned int numSamples)
+{
+    switch (interpolationType)
+    {
+    case Lagrange3:
+        readModulated<Lagrange3>(output, modInput, numChannels, numSamples);
+        break;
+
+    case Allpass:
+        readModulated<Allpass>(output, modInput, numChannels, numSamples);
+        break;
+
+    case Sinc:
+        readModulated<Sinc>(output, modInput, numChannels, numSamples);
+        break;
+
+    case Linear:
+    default:
+        readModulated<Linear>(output, modInput, numChannels, numSamples);
+        break;
+    }
+}
+
+void DelayLine::write(const float* const* input, unsigned int numChannels, unsigned int numSamples)
+{
     numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
     for (unsigned int ch = 0; ch < numChannels; ++ch)
     {
-        // Calculate base indices based on fixed delay time
         unsigned int workingWriteIndex { writeIndex };
-        unsigned int workingReadIndex { (workingWriteIndex + delayBufferSize - delaySamples) % delayBufferSize };
 
-        for (unsigned int n = 0; n < numSamples; ++n)
+        for (unsigned int n = 0; n < numSamples;)
         {
-            // Linear interpolation coefficients
-            const float m { std::fmax(modInput[ch][n], 0.f) };
-            const float mFloor { std::floor(m) };
-            const float mFrac0 { m - mFloor };
-            const float mFrac1 { 1.f - mFrac0 };
+            const unsigned int chunkSize { std::min(bufferSize, numSamples - n) };
+            writeSpan(ch, workingWriteIndex, input[ch] + n, chunkSize);
 
-            // Calculate read indices
-            const unsigned int readIndex0 { (workingReadIndex + delayBufferSize - static_cast<unsigned int>(mFloor)) % delayBufferSize };
-            const unsigned int readIndex1 { (readIndex0 + delayBufferSize - 1u) % delayBufferSize };
+            workingWriteIndex = wrap(workingWriteIndex + chunkSize);
+            n += chunkSize;
+        }
+    }
 
-            // Read from delay line
-            const float read0 = delayBuffer[ch][readIndex0];
-            const float read1 = delayBuffer[ch][readIndex1];
+    writeIndex = (writeIndex + numSamples) % bufferSize;
+}
+
+void DelayLine::setDelaySamples(unsigned int newDelaySamples)
+{
+    delaySamples = std::max(std::min(newDelaySamples, bufferSize - 1u), 1u);
+}
+
+void DelayLine::setInterpolationType(InterpolationType type)
+{
+    interpolationType = type;
+    std::fill(allpassStates.begin(), allpassStates.end(), 0.f);
+}
+
+template<DelayLine::InterpolationType Type>
+float DelayLine::readInterpolated(unsigned int channel, unsigned int index, float delay)
+{
+    const float* buffer { delayBuffer[channel].data() };
+
+    // Sample at an integer delay behind the most recent one
+    auto tap = [this, buffer, index] (unsigned int d) { return buffer[wrap(index + bufferSize - d)]; };
+
+    // std::min/max compile to single instructions, std::fmin/fmax may not
+    delay = std::min(std::max(delay, Type == Sinc ? static_cast<float>(SincTable::HalfTaps - 1) : 1.f), maxDelay);
+    const unsigned int d { static_cast<unsigned int>(delay) };
+    const float frac { delay - static_cast<float>(d) };
+
+    if constexpr (Type == Lagrange3)
+    {
+        // Taps at d-1, d, d+1, d+2 evaluated at d+frac
+        const float fp1 { frac + 1.f };
+        const float fm1 { frac - 1.f };
+        const float fm2 { frac - 2.f };
+        const float fm1fm2 { fm1 * fm2 };
+        const float fp1f { fp1 * frac };
+
+        const float h0 { -frac * fm1fm2 * (1.f / 6.f) };
+        const float h1 { fp1 * fm1fm2 * 0.5f };
+        const float h2 { -fp1f * fm2 * 0.5f };
+        const float h3 { fp1f * fm1 * (1.f / 6.f) };
+
+        return h0 * tap(d - 1u) + h1 * tap(d) + h2 * tap(d + 1u) + h3 * tap(d + 2u);
+    }
+    else if constexpr (Type == Allpass)
+    {
+        // Keep the fractional part in [0.5, 1.5) where the allpass is well behaved
+        const unsigned int d0 { frac < 0.5f ? d - 1u : d };
+        const float delta { frac < 0.5f ? frac + 1.f : frac };
 
-            // Read audio input
-            const float x { audioInput[ch][n] };
+        const float eta { allpassTable.coeffs[static_cast<unsigned int>((delta - 0.5f) * static_cast<float>(AllpassTable::Size) + 0.5f)] };
 
-            // Interpolate output
-            audioOutput[ch][n] = read0 * mFrac1 + read1 * mFrac0;
+        float& state { allpassStates[channel] };
+        state = eta * (tap(d0) - state) + tap(d0 + 1u);
+        return state;
+    }
+    else if constexpr (Type == Sinc)
+    {
+        // Blend the two nearest phases of the polyphase table
+        const float phase { frac * static_cast<float>(SincTable::Phases) };
+        const unsigned int p { static_cast<unsigned int>(phase) };
+        const float phaseFrac { phase - static_cast<float>(p) };
+        const float* h0 { sincTable.coeffs[p] };
+        const float* h1 { sincTable.coeffs[p + 1u] };
+
+        // Taps from d - HalfTaps + 1 to d + HalfTaps
+        float acc { 0.f };
+        for (unsigned int t = 0; t < SincTable::Taps; ++t)
+            acc += (h0[t] + phaseFrac * (h1[t] - h0[t])) * tap(d + t + 1u - SincTable::HalfTaps);
+
+        return acc;
+    }
+    else
+    {
+        return tap(d) * (1.f - frac) + tap(d + 1u) * frac;
+    }
+}
+
+template<DelayLine::InterpolationType Type>
+void DelayLine::processModulated(float* const* audioOutput, const float* const* audioInput, const float* const* modInput, unsigned int numChannels, unsigned int numSamples)
+{
+    const float fixedDelay { static_cast<float>(delaySamples) };
 
-            // Write input
-            delayBuffer[ch][workingWriteIndex] = x;
+    numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
+    for (unsigned int ch = 0; ch < numChannels; ++ch)
+    {
+        unsigned int workingWriteIndex { writeIndex };
 
-            // Increament indices
-            ++workingWriteIndex; workingWriteIndex %= delayBufferSize;
-            ++workingReadIndex; workingReadIndex %= delayBufferSize;
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
+            // Write input first, a delay of zero is the current input sample
+            delayBuffer[ch][workingWriteIndex] = audioInput[ch][n];
+
+            // Read from delay line
+            audioOutput[ch][n] = readInterpolated<Type>(ch, workingWriteIndex, fixedDelay + modInput[ch][n]);
+
+            // Increament index
+            workingWriteIndex = wrap(workingWriteIndex + 1u);
         }
     }
 
     // Update persistent write index
-    writeIndex += numSamples; writeIndex %= delayBufferSize;
+    writeIndex = (writeIndex + numSamples) % bufferSize;
 }
 
-void DelayLine::process(float* audioOutput, const float* audioInput, const float* modInput, unsigned int numChannels)
+template<DelayLine::InterpolationType Type>
+void DelayLine::readModulated(float* const* output, const float* const* modInput, unsigned int numChannels, unsigned int numSamples)
 {
-    const unsigned int delayBufferSize{ static_cast<unsigned int>(delayBuffer[0].size()) };
-
-    // Calculate base indices based on fixed delay time
-    unsigned int workingWriteIndex { writeIndex };
-    unsigned int workingReadIndex { (workingWriteIndex + delayBufferSize - delaySamples) % delayBufferSize };
+    const float fixedDelay { static_cast<float>(delaySamples) };
 
     numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
     for (unsigned int ch = 0; ch < numChannels; ++ch)
     {
-        // Linear interpolation coefficients
-        const float m { std::fmax(modInput[ch], 0.f) };
-        const float mFloor { std::floor(m) };
-        const float mFrac0 { m - mFloor };
-        const float mFrac1 { 1.f - mFrac0 };
+        // Position the n-th sample will be written to
+        unsigned int workingWriteIndex { writeIndex };
 
-        // Calculate read indeces
-        const unsigned int readIndex0 { (workingReadIndex + delayBufferSize - static_cast<unsigned int>(mFloor)) % delayBufferSize };
-        const unsigned int readIndex1 { (readIndex0 + delayBufferSize - 1u) % delayBufferSize };
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
+            output[ch][n] = readInterpolated<Type>(ch, workingWriteIndex, fixedDelay + modInput[ch][n]);
+            workingWriteIndex = wrap(workingWriteIndex + 1u);
+        }
+    }
+}
 
-        // Read from delay line
-        const float read0 = delayBuffer[ch][readIndex0];
-        const float read1 = delayBuffer[ch][readIndex1];
+template<DelayLine::InterpolationType Type>
+void DelayLine::processTapsInterpolated(float* const* output, const float* const* input, const Tap* taps, unsigned int numTaps, unsigned int numChannels, unsigned int numSamples)
+{
+    numChannels = std::min(numChannels, static_cast<unsigned int>(delayBuffer.size()));
+    for (unsigned int ch = 0; ch < numChannels; ++ch)
+    {
+        unsigned int workingWriteIndex { writeIndex };
 
-        // Read audio input
-        const float x { audioInput[ch] };
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
+            // Write once, then gather all taps around the same region of the buffer
+            delayBuffer[ch][workingWriteIndex] = input[ch][n];
+
+            float y { 0.f };
+            for (unsigned int t = 0; t < numTaps; ++t)
+            {
+                const Tap& tap { taps[t] };
+                const float delay { tap.modInput != nullptr ? tap.delaySamples + tap.modInput[ch][n] : tap.delaySamples };
+                const float x { tap.gain * readInterpolated<Type>(ch, workingWriteIndex, delay) };
+                if (tap.output != nullptr)
+                    tap.output[ch][n] = x;
+                else
+                    y += x;
+            }
+
+            if (output != nullptr)
+                output[ch][n] = y;
+
+            workingWriteIndex = wrap(workingWriteIndex + 1u);
+        }
+    }
 
-        // Interpolate output
-        audioOutput[ch] = read0 * mFrac1 + read1 * mFrac0;
+    writeIndex = (writeIndex + numSamples) % bufferSize;
+}
 
-        // Write input
-        delayBuffer[ch][workingWriteIndex] = x;
+void DelayLine::allocate(unsigned int maxLengthSamples, unsigned int numChannels, bool roundToPowerOfTwo)
+{
+    // Leave room for the widest interpolation kernel
+    bufferSize = std::max(maxLengthSamples, 2u * SincTable::Taps);
+
+    isPowerOfTwo = roundToPowerOfTwo;
+    if (isPowerOfTwo)
+    {
+        unsigned int size { 1u };
+        while (size < bufferSize)
+            size <<= 1;
+        bufferSize = size;
     }
+    bufferMask = bufferSize - 1u;
+    maxDelay = static_cast<float>(bufferSize - SincTable::HalfTaps - 1u);
 
-    // Update persistent write index
-    ++writeIndex; writeIndex %= delayBufferSize;
+    delayBuffer.clear();
+    for (unsigned int ch = 0; ch < numChannels; ++ch)
+        delayBuffer.emplace_back(bufferSize, 0.f);
+
+    allpassStates.assign(numChannels, 0.f);
 }
 
-void DelayLine::setDelaySamples(unsigned int newDelaySamples)
+void DelayLine::writeSpan(unsigned int channel, unsigned int index, const float* input, unsigned int numSamples)
 {
-    delaySamples = std::max(std::min(newDelaySamples, static_cast<unsigned int>(delayBuffer[0].size() - 1u)), 1u);
+    const unsigned int firstSpan { std::min(numSamples, bufferSize - index) };
+    std::memcpy(delayBuffer[channel].data() + index, input, firstSpan * sizeof(float));
+    std::memcpy(delayBuffer[channel].data(), input + firstSpan, (numSamples - firstSpan) * sizeof(float));
 }
 
+void DelayLine::readSpan(unsigned int channel, unsigned int index, float* output, unsigned int numSamples) const
+{
+    const unsigned int firstSpan { std::min(numSamples, bufferSize - index) };
+    std::memcpy(output, delayBuffer[channel].data() + index, firstSpan * sizeof(float));
+    std::memcpy(output + firstSpan, delayBuffer[channel].data(), (numSamples - firstSpan) * sizeof(float));
+}
 
-}
\ No newline at end of file
+}
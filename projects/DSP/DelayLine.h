@@ -8,7 +8,41 @@ namespace DSP
 class DelayLine
 {
 public:
-    DelayLine(unsigned int maxLengthSamples, unsigned int numChannels);
+    // Fractional delay interpolation used by the modulated processing
+    enum InterpolationType : unsigned int
+    {
+        // 2 taps, cheapest, dulls the high end for fractional delays
+        Linear = 0,
+
+        // 4 taps 3rd order Lagrange polynomial, flatter magnitude response
+        Lagrange3,
+
+        // 1st order Thiran allpass, flat magnitude response
+        // Best for slowly varying delays, fast modulation causes transients
+        Allpass,
+
+        // 8 taps polyphase windowed sinc, best quality and most expensive
+        // Requires a total delay of at least 3 samples
+        Sinc
+    };
+
+    // Read position of the multi-tap processing
+    // The delay is in samples and may be fractional, the optional modulation input
+    // holds per channel audio rate signals added on top of it
+    // A tap with its own per channel output, e.g. a chorus voice to pan or an echo to route
+    // to one side, writes its weighted signal there and is left out of the summed output
+    struct Tap
+    {
+        float delaySamples { 1.f };
+        float gain { 1.f };
+        const float* const* modInput { nullptr };
+        float* const* output { nullptr };
+    };
+
+    // Main ctor
+    // Optionally rounds the buffer capacity up to a power of two, which allows
+    // cheaper index wrapping on the processing paths at the cost of some memory
+    DelayLine(unsigned int maxLengthSamples, unsigned int numChannels, bool roundToPowerOfTwo = false);
     ~DelayLine();
 
     // No default ctor
@@ -26,9 +60,10 @@ public:
     void clear();
 
     // Reallocate delay buffer for the new channel count and clear its contents
-    void prepare(unsigned int maxLengthSamples, unsigned int numChannels);
+    void prepare(unsigned int maxLengthSamples, unsigned int numChannels, bool roundToPowerOfTwo = false);
 
     // Process audio with the currently (fixed) set delay time
+    // The delay buffer is read and written in contiguous spans
     void process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples);
 
     // Single sample flavour of the fixed delay time processing
@@ -37,20 +72,96 @@ public:
     // Process audio thru the delay line with audio rate modulation
     // The modulation input is a audio rate signal with the time modulation in samples
     // on top of the currently set delay time
-    // The modulation input supports fractional values and uses linear interpolation
+    // The modulation input supports fractional values and uses the selected interpolation
     void process(float* const* audioOutput, const float* const* audioInput, const float* const* modInput,
                  unsigned int numChannels, unsigned int numSamples);
 
     // Single sample flavour of the modulated delay time processing
     void process(float* audioOutput, const float* audioInput, const float* modInput, unsigned int numChannels);
 
+    // Process audio thru the delay line reading any number of taps
+    // Every input sample is written once and the output is the weighted sum of the taps
+    // without their own output, it may be nullptr if they all have one
+    // The taps use the selected interpolation, except allpass which falls back to linear
+    // as it would need a state per tap
+    void processTaps(float* const* output, const float* const* input, const Tap* taps, unsigned int numTaps,
+                     unsigned int numChannels, unsigned int numSamples);
+
+    // Split flavour of the modulated processing for feedback loops
+    // Reads a block of modulated taps relative to the samples that the next call
+    // to write will store, without advancing the delay line
+    // The total delay must be at least numSamples plus the interpolation
+    // look-ahead (0 linear, 1 Lagrange3, 3 sinc) so only already written samples are read
+    void read(float* const* output, const float* const* modInput, unsigned int numChannels, unsigned int numSamples);
+
+    // Write a block of samples and advance the delay line, see read
+    void write(const float* const* input, unsigned int numChannels, unsigned int numSamples);
+
     // Set the current delay time in samples
     void setDelaySamples(unsigned int samples);
 
+    // Select the fractional delay interpolation of the modulated processing
+    void setInterpolationType(InterpolationType type);
+
+    // Get the current buffer capacity in samples
+    unsigned int getBufferSize() const { return bufferSize; }
+
 private:
     std::vector<std::vector<float>> delayBuffer;
     unsigned int delaySamples { 0 };
     unsigned int writeIndex { 0 };
+
+    unsigned int bufferSize { 0 };
+    unsigned int bufferMask { 0 };
+    bool isPowerOfTwo { false };
+
+    InterpolationType interpolationType { Linear };
+
+    // Previous output of the allpass interpolator of every channel
+    std::vector<float> allpassStates;
+
+    // Longest fractional delay that keeps all interpolation taps inside the buffer
+    float maxDelay { 0.f };
+
+    // Spans shorter than this are not worth a memcpy call
+    static constexpr unsigned int MinSpanSize { 8 };
+
+    // Allocate the buffers and update the wrapping info
+    void allocate(unsigned int maxLengthSamples, unsigned int numChannels, bool roundToPowerOfTwo);
+
+    // Wrap an index which is less than twice the buffer size back into the buffer
+    unsigned int wrap(unsigned int index) const
+    {
+        if (isPowerOfTwo)
+            return index & bufferMask;
+
+        return index >= bufferSize ? index - bufferSize : index;
+    }
+
+    // Read a fractional delay from a channel, where index is the position of the
+    // most recently written sample
+    template<InterpolationType Type>
+    float readInterpolated(unsigned int channel, unsigned int index, float delay);
+
+    // Modulated processing for a given interpolation type
+    template<InterpolationType Type>
+    void processModulated(float* const* audioOutput, const float* const* audioInput, const float* const* modInput,
+                          unsigned int numChannels, unsigned int numSamples);
+
+    // Split modulated read for a given interpolation type
+    template<InterpolationType Type>
+    void readModulated(float* const* output, const float* const* modInput, unsigned int numChannels, unsigned int numSamples);
+
+    // Multi-tap processing for a given interpolation type
+    template<InterpolationType Type>
+    void processTapsInterpolated(float* const* output, const float* const* input, const Tap* taps, unsigned int numTaps,
+                                 unsigned int numChannels, unsigned int numSamples);
+
+    // Copy samples into the delay buffer of a channel, starting at a buffer index
+    void writeSpan(unsigned int channel, unsigned int index, const float* input, unsigned int numSamples);
+
+    // Copy samples out of the delay buffer of a channel, starting at a buffer index
+    void readSpan(unsigned int channel, unsigned int index, float* output, unsigned int numSamples) const;
 };
 
 }
\ No newline at end of file
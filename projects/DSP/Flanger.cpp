@@ -1,15 +1,18 @@
 #include "Flanger.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace DSP
 {
 
 Flanger::Flanger(float maxTimeMs, unsigned int numChannels) :
-    delayLine(static_cast<unsigned int>(std::ceil(std::fmax(maxTimeMs, 1.f) * static_cast<float>(0.001 * sampleRate))), numChannels),
+    delayLine(static_cast<unsigned int>(std::ceil(std::fmax(maxTimeMs, 1.f) * static_cast<float>(0.001 * sampleRate))), numChannels, true),
     offsetRamp(0.05f),
     modDepthRamp(0.05f)
 {
+    // Linear interpolation dulls the swept comb, cubic Lagrange keeps the highs
+    delayLine.setInterpolationType(DelayLine::Lagrange3);
 }
 
 Flanger::~Flanger()
@@ -20,7 +23,7 @@ void Flanger::prepare(double newSampleRate, float maxTimeMs, unsigned int numCha
 {
     sampleRate = newSampleRate;
 
-    delayLine.prepare(static_cast<unsigned int>(std::round(maxTimeMs * static_cast<float>(0.001 * sampleRate))), MaxChannels);
+    delayLine.prepare(static_cast<unsigned int>(std::round(maxTimeMs * static_cast<float>(0.001 * sampleRate))), MaxChannels, true);
     delayLine.setDelaySamples(static_cast<unsigned int>(std::ceil(0.001 * sampleRate))); // Set fixed delay to 1ms
 
     offsetRamp.prepare(sampleRate, true, offsetMs * static_cast<float>(0.001 * sampleRate));
@@ -38,44 +41,29 @@ void Flanger::clear()
 
 void Flanger::process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
 {
-    for (unsigned int n = 0; n < numSamples; ++n)
-    {
-        // Process LFO acording to mod type
-        float lfo[2] { 0.f, 0.f };
-        switch (modType)
-        {
-        case Tri:
-            lfo[0] = std::fabs((phaseState[0] - static_cast<float>(M_PI)) / static_cast<float>(M_PI));
-            lfo[1] = std::fabs((phaseState[1] - static_cast<float>(M_PI)) / static_cast<float>(M_PI));
-            break;
-
-        case Sin:
-            lfo[0] = 0.5f + 0.5f * std::sin(phaseState[0]);
-            lfo[1] = 0.5f + 0.5f * std::sin(phaseState[1]);
-            break;
-        }
+    numChannels = std::min(numChannels, static_cast<unsigned int>(MaxChannels));
 
-        // Increment and wrap phase states
-        phaseState[0] = std::fmod(phaseState[0] + phaseInc, static_cast<float>(2 * M_PI));
-        phaseState[1] = std::fmod(phaseState[1] + phaseInc, static_cast<float>(2 * M_PI));
+    float* mod[MaxChannels] { modBuffer[0], modBuffer[1] };
+    const float* x[MaxChannels] { nullptr, nullptr };
+    float* y[MaxChannels] { nullptr, nullptr };
 
-        // Apply mod depth and offset ramps
-        modDepthRamp.applyGain(lfo, numChannels);
-        offsetRamp.applySum(lfo, numChannels);
-
-        // Delay in/out
-        float x[2];
-        float y[2];
+    for (unsigned int offset = 0; offset < numSamples; offset += BlockSize)
+    {
+        const unsigned int blockSize { std::min(BlockSize, numSamples - offset) };
 
-        for (unsigned int ch = 0; ch < numChannels; ++ch)
-            x[ch] = input[ch][n];
+        // Build the delay time modulation for the whole block
+        processLFO(mod, blockSize);
+        modDepthRamp.applyGain(mod, numChannels, blockSize);
+        offsetRamp.applySum(mod, numChannels, blockSize);
 
         // Process delay
-        delayLine.process(y, x, lfo, numChannels);
-
-        // Write to output buffers
         for (unsigned int ch = 0; ch < numChannels; ++ch)
-            output[ch][n] = y[ch];
+        {
+            x[ch] = input[ch] + offset;
+            y[ch] = output[ch] + offset;
+        }
+
+        delayLine.process(y, x, mod, numChannels, blockSize);
     }
 }
 
@@ -104,4 +92,50 @@ void Flanger::setModulationType(ModulationType newModType)
     modType = newModType;
 }
 
+void Flanger::processLFO(float* const* lfo, unsigned int numSamples)
+{
+    const float twoPi { static_cast<float>(2.0 * M_PI) };
+
+    switch (modType)
+    {
+    case Tri:
+        for (unsigned int ch = 0; ch < MaxChannels; ++ch)
+        {
+            float phase { phaseState[ch] };
+            for (unsigned int n = 0; n < numSamples; ++n)
+            {
+                lfo[ch][n] = std::fabs((phase - static_cast<float>(M_PI)) / static_cast<float>(M_PI));
+                phase += phaseInc;
+                phase = phase >= twoPi ? phase - twoPi : phase;
+            }
+        }
+        break;
+
+    case Sin:
+        {
+            // Rotate a phasor instead of calling sin every sample,
+            // it is re-seeded from the phase state on every block so it does not drift
+            const float rotCos { std::cos(phaseInc) };
+            const float rotSin { std::sin(phaseInc) };
+            for (unsigned int ch = 0; ch < MaxChannels; ++ch)
+            {
+                float re { std::cos(phaseState[ch]) };
+                float im { std::sin(phaseState[ch]) };
+                for (unsigned int n = 0; n < numSamples; ++n)
+                {
+                    lfo[ch][n] = 0.5f + 0.5f * im;
+                    const float nextRe { re * rotCos - im * rotSin };
+                    im = re * rotSin + im * rotCos;
+                    re = nextRe;
+                }
+            }
+        }
+        break;
+    }
+
+    // Advance the phase states by the whole block
+    for (unsigned int ch = 0; ch < MaxChannels; ++ch)
+        phaseState[ch] = std::fmod(phaseState[ch] + static_cast<float>(numSamples) * phaseInc, twoPi);
+}
+
 }
\ No newline at end of file
@@ -52,6 +52,9 @@ public:
 
     static constexpr int MaxChannels { 2 };
 
+    // Internal processing block size for the modulation buffers
+    static constexpr unsigned int BlockSize { 64 };
+
 private:
     double sampleRate { 48000.0 };
 
@@ -68,6 +71,12 @@ private:
     float modRate { 0.f };
 
     ModulationType modType { Sin };
+
+    // Delay time modulation in samples, one block per channel
+    float modBuffer[MaxChannels][BlockSize];
+
+    // Fill the modulation buffers with a block of LFO samples in [0, 1]
+    void processLFO(float* const* lfo, unsigned int numSamples);
 };
 
 }
\ No newline at end of file
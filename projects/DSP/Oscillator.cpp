@@ -7,6 +7,11 @@ namespace DSP
 
 Oscillator::Oscillator()
 {
+    // Build the shared tables here rather than on the first use from the audio thread
+    for (unsigned int shape = 0; shape < Wavetable::NumShapes; ++shape)
+        Wavetable::get(static_cast<Wavetable::Shape>(shape));
+
+    updateTable();
 }
 
 Oscillator::~Oscillator()
@@ -18,9 +23,10 @@ void Oscillator::prepare(double newSampleRate)
     sampleRate = newSampleRate;
 
     // update phase increment for new sample rate
-    phaseInc = static_cast<float>(1.0 / sampleRate) * frequency;
+    updatePhaseInc();
 
-    differentiatorCoeff = static_cast<float>(sampleRate) / (4.f * frequency * (1.f - frequency / static_cast<float>(sampleRate)));
+    updateDifferentiatorCoeff();
+    updateTable();
 
     // reset states
     phaseState = 0.f;
@@ -29,34 +35,57 @@ void Oscillator::prepare(double newSampleRate)
 
 void Oscillator::process(float* output, unsigned int numSamples)
 {
-    for (unsigned int n = 0; n < numSamples; ++n)
+    // Dispatch once per block, every type runs its own branch free loop
+    switch (type)
     {
-        switch (type)
-        {
-        case Sin:
-            output[n] = std::sin(static_cast<float>(2.0 * M_PI) * phaseState);
-            break;
+    case Sin:
+    case SawWT:
+    case TriWT:
+    case SqrWT:
+        Wavetable::process(table, output, numSamples, phaseState, phaseInc);
+        break;
 
-        case TriAliased:
+    case TriAliased:
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
             output[n] = 4.f * std::fabs(phaseState - 0.5f) - 1.f;
-            break;
+            advancePhase();
+        }
+        break;
 
-        case SawAliased:
+    case SawAliased:
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
             output[n] = 2.f * phaseState - 1.f;
-            break;
+            advancePhase();
+        }
+        break;
 
-        case TriAA:
+    case TriAA:
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
             output[n] = dpwTri();
-            break;
+            advancePhase();
+        }
+        break;
 
-        case SawAA:
+    case SawAA:
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
             output[n] = dpwSaw();
-            break;
-
-        default: break;
+            advancePhase();
         }
+        break;
 
-        phaseState = std::fmod(phaseState + phaseInc, 1.f);
+    case SawBLEP:
+    case SqrBLEP:
+    case PulseBLEP:
+        processBlep(output, numSamples);
+        break;
+
+    default:
+        std::fill(output, output + numSamples, 0.f);
+        break;
     }
 }
 
@@ -67,8 +96,10 @@ float Oscillator::process()
     switch (type)
     {
     case Sin:
-        osc = std::sin(static_cast<float>(2.0 * M_PI) * phaseState);
-        break;
+    case SawWT:
+    case TriWT:
+    case SqrWT:
+        return Wavetable::process(table, phaseState, phaseInc);
 
     case TriAliased:
         osc = 4.f * std::fabs(phaseState - 0.5f) - 1.f;
@@ -86,10 +117,23 @@ float Oscillator::process()
         osc = dpwSaw();
         break;
 
+    case SawBLEP:
+        osc = 2.f * phaseState - 1.f - polyBlep(phaseState);
+        break;
+
+    case SqrBLEP:
+    case PulseBLEP:
+    {
+        const float width { type == SqrBLEP ? 0.5f : pulseWidth };
+        const float fallingPhase { phaseState - width + static_cast<float>(phaseState < width) };
+        osc = (phaseState < width ? 1.f : -1.f) + polyBlep(phaseState) - polyBlep(fallingPhase);
+        break;
+    }
+
     default: break;
     }
 
-    phaseState = std::fmod(phaseState + phaseInc, 1.f);
+    advancePhase();
 
     return osc;
 }
@@ -98,19 +142,57 @@ void Oscillator::setFrequency(float freqHz)
 {
     frequency = std::clamp(freqHz, 0.1f, 10000.f);
 
-    phaseInc = static_cast<float>(1.0 / sampleRate) * frequency;
-    differentiatorCoeff = static_cast<float>(sampleRate) / (4.f * frequency * (1.f - frequency / static_cast<float>(sampleRate)));
+    updatePhaseInc();
+    updateDifferentiatorCoeff();
+
+    if (wavetable != nullptr)
+        table = wavetable->getTable(phaseInc);
 }
 
 void Oscillator::setType(OscType newType)
 {
     type = newType;
+    updateDifferentiatorCoeff();
+    updateTable();
 
     // reset states
     phaseState = 0.f;
     differentiatorState = 0.f;
 }
 
+void Oscillator::setPulseWidth(float width)
+{
+    pulseWidth = std::clamp(width, 0.01f, 0.99f);
+}
+
+void Oscillator::updatePhaseInc()
+{
+    // The frequency range does not depend on the sample rate, e.g. 10 kHz is above Nyquist at 8 kHz
+    phaseInc = std::fmin(static_cast<float>(1.0 / sampleRate) * frequency, MaxPhaseInc);
+}
+
+void Oscillator::updateDifferentiatorCoeff()
+{
+    // Only the DPW types need it, spare the division on every frequency change otherwise
+    // sampleRate / (4 * frequency * (1 - frequency / sampleRate)), from the clamped increment
+    if (type == TriAA || type == SawAA)
+        differentiatorCoeff = 1.f / (4.f * phaseInc * (1.f - phaseInc));
+}
+
+void Oscillator::updateTable()
+{
+    switch (type)
+    {
+    case Sin: wavetable = &Wavetable::get(Wavetable::Sine); break;
+    case SawWT: wavetable = &Wavetable::get(Wavetable::Saw); break;
+    case TriWT: wavetable = &Wavetable::get(Wavetable::Triangle); break;
+    case SqrWT: wavetable = &Wavetable::get(Wavetable::Square); break;
+    default: wavetable = nullptr; break;
+    }
+
+    table = wavetable != nullptr ? wavetable->getTable(phaseInc) : nullptr;
+}
+
 float Oscillator::dpwSaw()
 {
     // unipolar to bipolar
@@ -149,4 +231,95 @@ float Oscillator::dpwTri()
     return 2.f * (output * differentiatorCoeff) + 1.f;
 }
 
+void Oscillator::processBlep(float* output, unsigned int numSamples)
+{
+    const float invPhaseInc { 1.f / phaseInc };
+    const float width { type == SqrBLEP ? 0.5f : pulseWidth };
+
+    for (unsigned int offset = 0; offset < numSamples; offset += BlepChunkSize)
+    {
+        const unsigned int chunkSize { std::min(BlepChunkSize, numSamples - offset) };
+        float* y { output + offset };
+
+        // Phases of the chunk without wrap around, the start phase is in [0, 1)
+        float unwrapped[BlepChunkSize];
+        for (unsigned int n = 0; n < chunkSize; ++n)
+            unwrapped[n] = phaseState + static_cast<float>(n) * phaseInc;
+
+        // Naive waveform, phases are positive so truncation is floor
+        if (type == SawBLEP)
+        {
+            for (unsigned int n = 0; n < chunkSize; ++n)
+            {
+                const float phase { unwrapped[n] - static_cast<float>(static_cast<int>(unwrapped[n])) };
+                y[n] = 2.f * phase - 1.f;
+            }
+
+            applyBlep(y, unwrapped, chunkSize, 0.f, -1.f, invPhaseInc);
+        }
+        else
+        {
+            for (unsigned int n = 0; n < chunkSize; ++n)
+            {
+                const float phase { unwrapped[n] - static_cast<float>(static_cast<int>(unwrapped[n])) };
+                y[n] = phase < width ? 1.f : -1.f;
+            }
+
+            applyBlep(y, unwrapped, chunkSize, 0.f, 1.f, invPhaseInc);
+            applyBlep(y, unwrapped, chunkSize, width, -1.f, invPhaseInc);
+        }
+
+        const float next { unwrapped[chunkSize - 1] + phaseInc };
+        phaseState = next - static_cast<float>(static_cast<int>(next));
+    }
+}
+
+void Oscillator::applyBlep(float* output, const float* unwrapped, unsigned int numSamples, float edge, float height, float invPhaseInc) const
+{
+    // Every k is a crossing of the edge between the sample before the chunk and the one after it,
+    // the sample after a crossing gets the first half of the residual and the one before it the second
+    const float firstPhase { unwrapped[0] - edge };
+    const float lastPhase { unwrapped[numSamples - 1] - edge };
+    const int last { static_cast<int>(numSamples) };
+
+    for (float k = std::floor(firstPhase - phaseInc) + 1.f; k <= lastPhase + phaseInc; k += 1.f)
+    {
+        // First sample at or past the crossing, the estimate is corrected for rounding
+        int m { std::clamp(static_cast<int>(std::ceil((k - firstPhase) * invPhaseInc)), 0, last) };
+        while (m > 0 && unwrapped[m - 1] - edge >= k)
+            --m;
+        while (m < last && unwrapped[m] - edge < k)
+            ++m;
+
+        if (m < last)
+        {
+            const float t { (unwrapped[m] - edge - k) * invPhaseInc };
+            output[m] += height * (t + t - t * t - 1.f);
+        }
+
+        if (m > 0)
+        {
+            const float t { (unwrapped[m - 1] - edge - k) * invPhaseInc };
+            output[m - 1] += height * (t * t + t + t + 1.f);
+        }
+    }
+}
+
+float Oscillator::polyBlep(float phase) const
+{
+    if (phase < phaseInc)
+    {
+        const float t { phase / phaseInc };
+        return t + t - t * t - 1.f;
+    }
+
+    if (phase > 1.f - phaseInc)
+    {
+        const float t { (phase - 1.f) / phaseInc };
+        return t * t + t + t + 1.f;
+    }
+
+    return 0.f;
+}
+
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Wavetable.h"
+
 namespace DSP
 {
 
@@ -12,7 +14,13 @@ public:
         TriAliased,
         SawAliased,
         TriAA,
-        SawAA
+        SawAA,
+        SawWT,
+        TriWT,
+        SqrWT,
+        SawBLEP,
+        SqrBLEP,
+        PulseBLEP
     };
 
     Oscillator();
@@ -38,6 +46,9 @@ public:
     // Select the waveform type
     void setType(OscType type);
 
+    // Duty cycle of PulseBLEP, from 0.01 to 0.99
+    void setPulseWidth(float width);
+
 private:
     double sampleRate { 48000.0 };
 
@@ -47,13 +58,49 @@ private:
     float phaseState { 0.f };
     float phaseInc { 0.f };
 
+    // Phase increments are kept at or below Nyquist, a frequency above it would alias anyway
+    // and the PolyBLEP residual needs a period of at least two samples
+    static constexpr float MaxPhaseInc { 0.5f };
+
+    void updatePhaseInc();
+
     float differentiatorState { 0.f };
     float differentiatorCoeff { 0.f };
 
+    // Band-limited table of the current frequency, used by Sin and the wavetable types
+    const Wavetable* wavetable { nullptr };
+    const float* table { nullptr };
+
+    void updateTable();
+
+    // Phase advance with wrap around, phases are positive so truncation is floor
+    void advancePhase()
+    {
+        phaseState += phaseInc;
+        phaseState -= static_cast<float>(static_cast<int>(phaseState));
+    }
+
+    float pulseWidth { 0.5f };
+
     // DPW methods
 
+    void updateDifferentiatorCoeff();
     float dpwTri();
     float dpwSaw();
+
+    // PolyBLEP methods
+    // The naive waveform of a chunk is computed from its phases in one vectorizable pass,
+    // the two sample polynomial residual is then added only around the edges of the chunk
+
+    static constexpr unsigned int BlepChunkSize { 64 };
+
+    void processBlep(float* output, unsigned int numSamples);
+
+    // Add the residual of a step of 2 * height at phase edge, unwrapped holds the phases of the chunk
+    void applyBlep(float* output, const float* unwrapped, unsigned int numSamples, float edge, float height, float invPhaseInc) const;
+
+    // Residual of a downward step of 2 at phase 0 for a single sample
+    float polyBlep(float phase) const;
 };
 
 }
@@ -0,0 +1,248 @@
+#include "ParallelSynthesiser.h"
+
+#include <thread>
+
+namespace DSP
+{
+
+ParallelSynthesiser::ParallelSynthesiser(int numWorkers)
+{
+    const int maxNumWorkers { std::clamp(juce::SystemStats::getNumCpus() - 1, 0, MaxWorkers) };
+    numWorkers = numWorkers < 0 ? maxNumWorkers : std::min(numWorkers, maxNumWorkers);
+
+    for (int i = 0; i < numWorkers; ++i)
+        workers.emplace_back(std::make_unique<Worker>(*this, i));
+}
+
+ParallelSynthesiser::~ParallelSynthesiser()
+{
+    // Stop the workers before the base class deletes the voices
+    workers.clear();
+}
+
+void ParallelSynthesiser::prepare(double sampleRate, int newMaxBlockSize, int numChannels)
+{
+    // prepareToPlay never runs during processBlock, but a worker that missed its deadline may still render a voice
+    while (hasLateVoices())
+        juce::Thread::sleep(LatePollMs);
+
+    setCurrentPlaybackSampleRate(sampleRate);
+
+    maxBlockSize = newMaxBlockSize;
+    maxNumChannels = numChannels;
+
+    const int numVoices { getNumVoices() };
+    jobs.resize(static_cast<size_t>(numVoices));
+    lateVoices.clear();
+    lateVoices.reserve(static_cast<size_t>(numVoices));
+    renderedGenerations = std::make_unique<std::atomic<uint32_t>[]>(static_cast<size_t>(numVoices));
+
+    voiceBuffers.resize(static_cast<size_t>(numVoices));
+    for (auto& buffer : voiceBuffers)
+        buffer.setSize(numChannels, maxBlockSize);
+
+    // Room for a few hundred short messages held back while a voice is late
+    deferredMidi.ensureSize(4096);
+
+    maxWaitTicksPerSample = static_cast<double>(juce::Time::secondsToHighResolutionTicks(1.0)) * MaxWaitShare / sampleRate;
+
+    for (auto& worker : workers)
+        if (!worker->isThreadRunning() && !worker->startRealtimeThread(juce::Thread::RealtimeOptions {}))
+            worker->startThread(juce::Thread::Priority::highest);
+}
+
+bool ParallelSynthesiser::hasLateVoices()
+{
+    // Drop the voices whose job is done by now
+    for (size_t i = 0; i < lateVoices.size();)
+    {
+        if (renderedGenerations[static_cast<size_t>(lateVoices[i].index)].load(std::memory_order_acquire) == lateVoices[i].generation)
+        {
+            lateVoices[i] = lateVoices.back();
+            lateVoices.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    return !lateVoices.empty();
+}
+
+void ParallelSynthesiser::handleMidiEvent(const juce::MidiMessage& message)
+{
+    // A late voice may be stopped or stolen by the event, hold it back
+    if (hasLateVoices())
+    {
+        deferredMidi.addEvent(message, 0);
+        return;
+    }
+
+    flushDeferredMidi();
+    juce::Synthesiser::handleMidiEvent(message);
+}
+
+void ParallelSynthesiser::flushDeferredMidi()
+{
+    if (deferredMidi.isEmpty())
+        return;
+
+    for (const auto metadata : deferredMidi)
+        juce::Synthesiser::handleMidiEvent(metadata.getMessage());
+    deferredMidi.clear();
+}
+
+bool ParallelSynthesiser::isLateVoice(int index) const
+{
+    return std::any_of(lateVoices.begin(), lateVoices.end(), [index] (const LateVoice& late) { return late.index == index; });
+}
+
+void ParallelSynthesiser::renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples)
+{
+    // Late voices stay out until their worker is done, then the MIDI held back for them goes first
+    const bool hasLate { hasLateVoices() };
+    if (!hasLate)
+        flushDeferredMidi();
+
+    // Inactive voices render silence, leave them out
+    // Voices added after prepare do not fit the job list, and the job list of a dispatch that timed out
+    // is still read by its late workers, the voices are rendered right away in both cases
+    const bool renderNow { hasLate || static_cast<int>(jobs.size()) < voices.size() };
+    int numJobs { 0 };
+    for (int i = 0; i < voices.size(); ++i)
+    {
+        auto* voice { voices.getUnchecked(i) };
+        if ((hasLate && isLateVoice(i)) || !voice->isVoiceActive())
+            continue;
+
+        if (renderNow)
+            voice->renderNextBlock(outputAudio, startSample, numSamples);
+        else
+            jobs[static_cast<size_t>(numJobs++)] = { voice, i, false };
+    }
+
+    if (renderNow)
+        return;
+
+    // Workers render at the block position into buffers of maxBlockSize samples
+    const bool renderSerially { workers.empty() || numJobs < 2 || numSamples < MinParallelBlockSize
+                             || startSample + numSamples > maxBlockSize || outputAudio.getNumChannels() > maxNumChannels };
+    if (renderSerially)
+    {
+        for (int j = 0; j < numJobs; ++j)
+            jobs[static_cast<size_t>(j)].voice->renderNextBlock(outputAudio, startSample, numSamples);
+        return;
+    }
+
+    // Publish the dispatch, the job list and the block are only read after claiming a job of it
+    const juce::int64 dispatchTicks { juce::Time::getHighResolutionTicks() };
+    jobStartSample = startSample;
+    jobNumSamples = numSamples;
+    if (++generation == 0)
+        ++generation;
+    completedJobs.store(static_cast<uint64_t>(generation) << 32, std::memory_order_relaxed);
+    jobState.store(packJobState(generation, static_cast<uint32_t>(numJobs), 0));
+
+    // One worker per job the audio thread does not take, a worker woken after the jobs are gone goes back to sleep
+    const int numToWake { std::min(numJobs - 1, static_cast<int>(workers.size())) };
+    for (int w = 0; w < numToWake; ++w)
+        workers[static_cast<size_t>(w)]->notify();
+
+    // The audio thread works too, straight into the output
+    renderJobs(generation, &outputAudio);
+
+    // Every job is claimed at this point, wait for the workers still rendering theirs,
+    // but not past a share of the block, a preempted worker must not stall the callback
+    const juce::int64 deadlineTicks { dispatchTicks + static_cast<juce::int64>(maxWaitTicksPerSample * numSamples) };
+    while ((completedJobs.load(std::memory_order_acquire) & 0xffffffffu) < static_cast<uint64_t>(numJobs)
+           && juce::Time::getHighResolutionTicks() < deadlineTicks)
+        std::this_thread::yield();
+
+    // Every finished voice is mixed, also after a timeout, the others miss this block and are late until their worker is done
+    // Whether a job went into its voice buffer is only read once the job is released as done
+    for (int j = 0; j < numJobs; ++j)
+    {
+        const Job& job { jobs[static_cast<size_t>(j)] };
+        if (renderedGenerations[static_cast<size_t>(job.index)].load(std::memory_order_acquire) != generation)
+        {
+            lateVoices.push_back({ job.index, generation });
+            continue;
+        }
+
+        if (job.inVoiceBuffer)
+            for (int ch = 0; ch < outputAudio.getNumChannels(); ++ch)
+                outputAudio.addFrom(ch, startSample, voiceBuffers[static_cast<size_t>(job.index)], ch, startSample, numSamples);
+    }
+}
+
+int ParallelSynthesiser::claimJob(uint32_t dispatchGeneration)
+{
+    uint64_t state { jobState.load(std::memory_order_acquire) };
+    while (getGeneration(state) == dispatchGeneration)
+    {
+        const uint32_t numJobs { static_cast<uint32_t>(state >> 16) & 0xffffu };
+        const uint32_t nextJob { static_cast<uint32_t>(state) & 0xffffu };
+        if (nextJob >= numJobs)
+            break;
+
+        if (jobState.compare_exchange_weak(state, state + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+            return static_cast<int>(nextJob);
+    }
+
+    return -1;
+}
+
+void ParallelSynthesiser::renderJobs(uint32_t dispatchGeneration, juce::AudioBuffer<float>* output)
+{
+    for (int claimed { claimJob(dispatchGeneration) }; claimed >= 0; claimed = claimJob(dispatchGeneration))
+    {
+        Job& job { jobs[static_cast<size_t>(claimed)] };
+
+        // Workers render into the voice buffer, cleared first as voices add to what is there
+        job.inVoiceBuffer = output == nullptr;
+        auto& buffer { job.inVoiceBuffer ? voiceBuffers[static_cast<size_t>(job.index)] : *output };
+        if (job.inVoiceBuffer)
+            buffer.clear(jobStartSample, jobNumSamples);
+
+        job.voice->renderNextBlock(buffer, jobStartSample, jobNumSamples);
+
+        // Releases the voice and its buffer to the audio thread, even if it stopped waiting
+        renderedGenerations[static_cast<size_t>(job.index)].store(dispatchGeneration, std::memory_order_release);
+
+        // Counts the job for the wait, unless a newer dispatch started meanwhile
+        uint64_t completed { completedJobs.load(std::memory_order_relaxed) };
+        while (getGeneration(completed) == dispatchGeneration
+               && !completedJobs.compare_exchange_weak(completed, completed + 1, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+ParallelSynthesiser::Worker::Worker(ParallelSynthesiser& _owner, int index) :
+    juce::Thread("Synth Worker " + juce::String(index)),
+    owner { _owner }
+{
+}
+
+ParallelSynthesiser::Worker::~Worker()
+{
+    stopThread(1000);
+}
+
+void ParallelSynthesiser::Worker::run()
+{
+    juce::ScopedNoDenormals noDenormals;
+
+    // Sleep until the audio thread publishes jobs, stopThread wakes the worker as well
+    while (!threadShouldExit())
+    {
+        wait(-1);
+        if (threadShouldExit())
+            break;
+
+        owner.renderJobs(getGeneration(owner.jobState.load(std::memory_order_acquire)), nullptr);
+    }
+}
+
+}
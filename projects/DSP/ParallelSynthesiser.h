@@ -0,0 +1,140 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace DSP
+{
+
+// juce::Synthesiser that renders its active voices on a pool of worker threads
+// The audio thread publishes the active voices as jobs and renders alongside the workers,
+// which claim jobs with a single atomic compare and swap and render each into the buffer of its voice
+//
+// Idle workers sleep on their thread event, the audio thread wakes one per job besides its own with notify()
+// Nothing is allocated from the audio thread, the notify only takes the event's lock for the signal,
+// a worker never holds it while rendering
+//
+// The wait for the workers is bounded to MaxWaitShare of the block duration. Every voice finished by then
+// is mixed, a voice whose worker misses it, e.g. preempted without realtime priority, is left out of the block
+// and stays out of rendering, MIDI and parameter updates until it is done, see hasLateVoices
+class ParallelSynthesiser : public juce::Synthesiser
+{
+public:
+    // At most one worker per core besides the audio thread, -1 for one per core, 0 renders everything serially
+    // Every instance has its own workers, so the default stays small
+    explicit ParallelSynthesiser(int numWorkers = DefaultNumWorkers);
+    ~ParallelSynthesiser() override;
+
+    // Set the sample rate of the voices, allocate the voice buffers and start the workers
+    // Call on prepareToPlay after adding the voices
+    void prepare(double sampleRate, int maxBlockSize, int numChannels);
+
+    int getNumWorkers() const { return static_cast<int>(workers.size()); }
+
+    // True while a worker that missed its deadline still renders a voice
+    // Audio thread only, changes to the voices, e.g. parameter updates, have to wait until it returns false
+    bool hasLateVoices();
+
+    // MIDI arriving while a voice is late is held back and handled once the voice is done
+    void handleMidiEvent(const juce::MidiMessage& message) override;
+
+    // Blocks shorter than this, e.g. the slices between MIDI events, are rendered serially
+    static constexpr int MinParallelBlockSize { 32 };
+
+    // Polling period of prepare while a late voice is still rendered
+    static constexpr int LatePollMs { 1 };
+
+    // Share of the block duration the audio thread waits for the workers
+    static constexpr double MaxWaitShare { 0.5 };
+
+    static constexpr int DefaultNumWorkers { 2 };
+    static constexpr int MaxWorkers { 15 };
+
+protected:
+    using juce::Synthesiser::renderVoices;
+    void renderVoices(juce::AudioBuffer<float>& outputAudio, int startSample, int numSamples) override;
+
+private:
+    class Worker : public juce::Thread
+    {
+    public:
+        Worker(ParallelSynthesiser& _owner, int index);
+        ~Worker() override;
+
+        void run() override;
+
+    private:
+        ParallelSynthesiser& owner;
+    };
+
+    struct Job
+    {
+        juce::SynthesiserVoice* voice;
+        int index;
+
+        // Set by whoever renders the job, true if it went into the voice buffer rather than the output
+        bool inVoiceBuffer;
+    };
+
+    // Voice a worker was still rendering when the audio thread stopped waiting
+    struct LateVoice
+    {
+        int index;
+        uint32_t generation;
+    };
+
+    // Job state of the current dispatch packed in one word, so a claim can never mix two dispatches
+    // | generation (32 bits) | number of jobs (16 bits) | next job (16 bits) |
+    static uint64_t packJobState(uint32_t generation, uint32_t numJobs, uint32_t nextJob)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(numJobs) << 16) | nextJob;
+    }
+
+    static uint32_t getGeneration(uint64_t state) { return static_cast<uint32_t>(state >> 32); }
+
+    // Claim the next job of a dispatch, returns -1 once they are all taken or the dispatch is over
+    int claimJob(uint32_t generation);
+
+    // Claim and render jobs of a dispatch until none are left, into output or, for the workers, into the voice buffers
+    void renderJobs(uint32_t generation, juce::AudioBuffer<float>* output);
+
+    bool isLateVoice(int index) const;
+
+    // Handle the MIDI held back while voices were late
+    void flushDeferredMidi();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Active voices of the current dispatch, sized for all voices on prepare
+    std::vector<Job> jobs;
+    int jobStartSample { 0 };
+    int jobNumSamples { 0 };
+
+    std::atomic<uint64_t> jobState { 0 };
+
+    // Finished jobs of the current dispatch, with the generation in the upper 32 bits
+    // so a late worker finishing a job of an older dispatch does not count for the current one
+    std::atomic<uint64_t> completedJobs { 0 };
+    uint32_t generation { 0 };
+
+    // Generation of the last dispatch that rendered each voice, stored once its job is done
+    std::unique_ptr<std::atomic<uint32_t>[]> renderedGenerations;
+
+    // One buffer of maxBlockSize samples per voice, only written by the worker rendering its job,
+    // so a voice finished after a timeout never shares a buffer with one that is not
+    std::vector<juce::AudioBuffer<float>> voiceBuffers;
+
+    // Sized for all voices on prepare, a voice is late at most once
+    std::vector<LateVoice> lateVoices;
+
+    juce::MidiBuffer deferredMidi;
+
+    // High resolution ticks the audio thread waits per sample
+    double maxWaitTicksPerSample { 0.0 };
+
+    int maxBlockSize { 0 };
+    int maxNumChannels { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParallelSynthesiser)
+};
+
+}
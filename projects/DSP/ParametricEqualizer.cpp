@@ -5,13 +5,14 @@
 namespace DSP
 {
 
-ParametricEqualizer::ParametricEqualizer(unsigned int numOfBands, unsigned int maxNumChannels) :
-    biquad(numOfBands, maxNumChannels),
+ParametricEqualizer::ParametricEqualizer(unsigned int numOfBands, unsigned int maxNumChannels, Realization newRealization) :
+    biquad(newRealization == DirectForm1 ? numOfBands : 0, maxNumChannels),
+    biquadTDF2(newRealization == TransposedDirectForm2 ? numOfBands : 0, maxNumChannels),
+    realization { newRealization },
     bands(numOfBands)
 {
-    unsigned int b { 0 };
-    for (const auto& band : bands)
-        biquad.setSectionCoeffs(calculateCoeffs(band), b++);
+    for (unsigned int b = 0; b < bands.size(); ++b)
+        updateBandCoeffs(b, true);
 }
 
 ParametricEqualizer::~ParametricEqualizer()
@@ -21,65 +22,81 @@ ParametricEqualizer::~ParametricEqualizer()
 void ParametricEqualizer::clear()
 {
     biquad.clear();
+    biquadTDF2.clear();
 }
 
 void ParametricEqualizer::prepare(double newSampleRate, unsigned int maxNumChannels)
 {
     biquad.reallocateChannels(maxNumChannels);
+    biquadTDF2.reallocateChannels(maxNumChannels);
 
     sampleRate = std::fmax(newSampleRate, 1.f);
+    biquadTDF2.prepare(sampleRate);
 
-    unsigned int b { 0 };
-    for (const auto& band : bands)
-        biquad.setSectionCoeffs(calculateCoeffs(band), b++);
+    for (unsigned int b = 0; b < bands.size(); ++b)
+        updateBandCoeffs(b, true);
 }
 
 void ParametricEqualizer::process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
 {
-    biquad.process(output, input, numChannels, numSamples);
+    if (realization == TransposedDirectForm2)
+        biquadTDF2.process(output, input, numChannels, numSamples);
+    else
+        biquad.process(output, input, numChannels, numSamples);
 }
 
 void ParametricEqualizer::process(float* output, const float* input, unsigned int numChannels)
 {
-    biquad.process(output, input, numChannels);
+    if (realization == TransposedDirectForm2)
+        biquadTDF2.process(output, input, numChannels);
+    else
+        biquad.process(output, input, numChannels);
 }
 
 void ParametricEqualizer::setBandType(unsigned int band, FilterType type)
 {
-    if (band < bands.size() && band < biquad.getAllocatedSections())
+    if (band < bands.size())
     {
         bands[band].type = type;
-        biquad.setSectionCoeffs(calculateCoeffs(bands[band]), band);
+        updateBandCoeffs(band, false);
     }
 }
 
 void ParametricEqualizer::setBandFrequency(unsigned int band, float frequency)
 {
-    if (band < bands.size() && band < biquad.getAllocatedSections())
+    if (band < bands.size())
     {
         bands[band].freq = std::fmax(frequency, 2.f);
-        biquad.setSectionCoeffs(calculateCoeffs(bands[band]), band);
+        updateBandCoeffs(band, false);
     }
 }
 
 void ParametricEqualizer::setBandResonance(unsigned int band, float resonance)
 {
-    if (band < bands.size() && band < biquad.getAllocatedSections())
+    if (band < bands.size())
     {
         bands[band].reso = std::fmax(resonance, 0.1f);
-        biquad.setSectionCoeffs(calculateCoeffs(bands[band]), band);
+        updateBandCoeffs(band, false);
     }
 }
 
 void ParametricEqualizer::setBandGain(unsigned int band, float gain)
 {
-    if (band < bands.size() && band < biquad.getAllocatedSections())
+    if (band < bands.size())
     {
         bands[band].gain = gain;
-        biquad.setSectionCoeffs(calculateCoeffs(bands[band]), band);
+        updateBandCoeffs(band, false);
     }
 }
 
+void ParametricEqualizer::updateBandCoeffs(unsigned int band, bool skipRamp)
+{
+    if (realization == TransposedDirectForm2)
+        biquadTDF2.setSectionCoeffs(calculateCoeffs(bands[band]), band, skipRamp);
+    else
+        biquad.setSectionCoeffs(calculateCoeffs(bands[band]), band);
+}
+
 std::array<float, DSP::Biquad::CoeffsPerSection> ParametricEqualizer::calculateCoeffs(const Band& band)
 {
     // Flat coeffs
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Biquad.h"
+#include "BiquadTDF2.h"
 
 namespace DSP
 {
@@ -18,11 +19,22 @@ public:
         HighShelf
     };
 
+    enum Realization : unsigned int
+    {
+        // Direct Form I, coefficients are swapped immediately
+        // Vectorised across channels, best suited for static settings
+        DirectForm1 = 0,
+
+        // Transposed Direct Form II, coefficients are ramped
+        // Best suited for fast automation of the band settings
+        TransposedDirectForm2
+    };
+
     // Main ctor
     // Requires number of bands and channels to be allocated
     // The number of bands cannot be modified later but channels can be reallocated
     // All bands filters will be initialised to Flat
-    ParametricEqualizer(unsigned int numOfBands, unsigned int maxNumChannels = 2);
+    ParametricEqualizer(unsigned int numOfBands, unsigned int maxNumChannels = 2, Realization realization = DirectForm1);
 
     // Dtor
     ~ParametricEqualizer();
@@ -65,8 +77,11 @@ public:
     void setBandGain(unsigned int band, float gain);
 
 private:
-    // Biquad structure for filter realization
+    // Biquad structures for filter realization
+    // only the one selected by the realization has sections allocated
     DSP::Biquad biquad;
+    DSP::BiquadTDF2 biquadTDF2;
+    const Realization realization;
 
     // Current sample rate of coefficients
     double sampleRate { 48000.0 };
@@ -85,6 +100,9 @@ private:
 
     // Helper function to calculate coefficients
     std::array<float, DSP::Biquad::CoeffsPerSection> calculateCoeffs(const Band & band);
+
+    // Helper function to send the coefficients of a band to the active realization
+    void updateBandCoeffs(unsigned int band, bool skipRamp);
 };
 
 }
\ No newline at end of file
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <type_traits>
+
+#include "SIMD.h"
 
 namespace DSP
 {
@@ -51,6 +55,12 @@ public:
             targetValue = newTargetValue;
             rampStep = (targetValue - currentValue) / static_cast<F>(sampleRate * rampTime);
         }
+        else
+        {
+            // Close enough to the current value, settle on the next sample
+            targetValue = newTargetValue;
+            rampStep = static_cast<F>(0);
+        }
 
         if (skipRamp)
             currentValue = targetValue = newTargetValue;
@@ -65,93 +75,82 @@ public:
     // Apply summing ramp to a single sample in-place
     void applySum(F* buffers, unsigned int numChannels)
     {
-        const F targetDelta { std::fabs(targetValue - currentValue) };
-        if ((targetDelta > std::fabs(static_cast<F>(2) * rampStep)) && (std::fabs(rampStep) > minDelta))
-            currentValue += rampStep;
-        else
-            currentValue = targetValue;
-
+        const F value { getNext() };
         for (unsigned int ch = 0; ch < numChannels; ++ch)
-            buffers[ch] += currentValue;
+            buffers[ch] += value;
     }
 
     // Apply summing ramp to an audio buffer in-place
     void applySum(F* const* buffers, unsigned int numChannels, unsigned int numSamples)
     {
-        for (unsigned int n = 0; n < numSamples; ++n)
-        {
-            const F targetDelta { std::fabs(targetValue - currentValue) };
-            if ((targetDelta > std::fabs(static_cast<F>(2) * rampStep)) && (std::fabs(rampStep) > minDelta))
-                currentValue += rampStep;
-            else
-                currentValue = targetValue;
-
-            for (unsigned int ch = 0; ch < numChannels; ++ch)
-                buffers[ch][n] += currentValue;
-        }
+        applySum(buffers, buffers, numChannels, numSamples);
     }
 
     // Apply summing ramp to an audio buffer out-of-place
     void applySum(F* const* output, const F* const* input, unsigned int numChannels, unsigned int numSamples)
     {
-        for (unsigned int n = 0; n < numSamples; ++n)
+        const unsigned int numRampSamples { getNumRampSamples(numSamples) };
+        for (unsigned int ch = 0; ch < numChannels; ++ch)
         {
-            const F targetDelta { std::fabs(targetValue - currentValue) };
-            if ((targetDelta > std::fabs(static_cast<F>(2) * rampStep)) && (std::fabs(rampStep) > minDelta))
-                currentValue += rampStep;
-            else
-                currentValue = targetValue;
-
-            for (unsigned int ch = 0; ch < numChannels; ++ch)
-                output[ch][n] = currentValue + input[ch][n];
+            sumRamp(output[ch], input[ch], currentValue, rampStep, numRampSamples);
+            sumConstant(output[ch] + numRampSamples, input[ch] + numRampSamples, targetValue, numSamples - numRampSamples);
         }
+
+        advance(numRampSamples, numSamples);
     }
 
     // Apply gain ramp to an audio buffer in-place for single sample
     void applyGain(F* buffers, unsigned int numChannels)
     {
-        const F targetDelta { std::fabs(targetValue - currentValue) };
-        if ((targetDelta > std::fabs(static_cast<F>(2) * rampStep)) && (std::fabs(rampStep) > minDelta))
-            currentValue += rampStep;
-        else
-            currentValue = targetValue;
-
+        const F value { getNext() };
         for (unsigned int ch = 0; ch < numChannels; ++ch)
-            buffers[ch] *= currentValue;
+            buffers[ch] *= value;
     }
 
     // Apply gain ramp to an audio buffer in-place
     void applyGain(F* const* buffers, unsigned int numChannels, unsigned int numSamples)
     {
-        for (unsigned int n = 0; n < numSamples; ++n)
-        {
-            const F targetDelta { std::fabs(targetValue - currentValue) };
-            if ((targetDelta > std::fabs(static_cast<F>(2) * rampStep)) && (std::fabs(rampStep) > minDelta))
-                currentValue += rampStep;
-            else
-                currentValue = targetValue;
-
-            for (unsigned int ch = 0; ch < numChannels; ++ch)
-                buffers[ch][n] *= currentValue;
-        }
+        applyGain(buffers, buffers, numChannels, numSamples);
     }
 
     // Apply gain ramp to an audio buffer out-of-place
     void applyGain(F* const* output, const F* const* input, unsigned int numChannels, unsigned int numSamples)
     {
-        for (unsigned int n = 0; n < numSamples; ++n)
+        const unsigned int numRampSamples { getNumRampSamples(numSamples) };
+        for (unsigned int ch = 0; ch < numChannels; ++ch)
         {
-            const F targetDelta{ std::fabs(targetValue - currentValue) };
-            if ((targetDelta > std::fabs(static_cast<F>(2) * rampStep)) && (std::fabs(rampStep) > minDelta))
-                currentValue += rampStep;
-            else
-                currentValue = targetValue;
-
-            for (unsigned int ch = 0; ch < numChannels; ++ch)
-                output[ch][n] = currentValue * input[ch][n];
+            gainRamp(output[ch], input[ch], currentValue, rampStep, numRampSamples);
+            gainConstant(output[ch] + numRampSamples, input[ch] + numRampSamples, targetValue, numSamples - numRampSamples);
         }
+
+        advance(numRampSamples, numSamples);
+    }
+
+    // Fill a buffer with the next values of the ramp
+    void getNext(F* output, unsigned int numSamples)
+    {
+        const unsigned int numRampSamples { getNumRampSamples(numSamples) };
+        for (unsigned int n = 0; n < numRampSamples; ++n)
+            output[n] = currentValue + static_cast<F>(n + 1) * rampStep;
+        std::fill(output + numRampSamples, output + numSamples, targetValue);
+
+        advance(numRampSamples, numSamples);
     }
 
+    // Advance the ramp by a number of samples without applying it
+    // Returns the value reached after the last sample
+    F skip(unsigned int numSamples)
+    {
+        advance(getNumRampSamples(numSamples), numSamples);
+        return currentValue;
+    }
+
+    // Current value of the ramp, without advancing it
+    F getCurrent() const { return currentValue; }
+
+    // Value the ramp is heading to
+    F getTarget() const { return targetValue; }
+
     float getNext()
     {
         const F targetDelta { std::fabs(targetValue - currentValue) };
@@ -170,6 +169,106 @@ public:
     static constexpr F minDelta { static_cast<F>(1e-9) };
 
 private:
+    // Number of samples of a block, starting from the next one, that are still
+    // ramping, the ramp sits on its target for the rest of the block
+    // Equivalent to stepping sample by sample while the distance to the target
+    // is larger than two steps
+    unsigned int getNumRampSamples(unsigned int numSamples) const
+    {
+        const F absStep { std::abs(rampStep) };
+        if (absStep <= minDelta)
+            return 0;
+
+        // Ramps usually land exactly on a step boundary, where stepping sample by sample
+        // takes the last step and snaps on the next sample, the small bias makes sure
+        // rounding noise does not end the ramp one sample early
+        const F stepsToTarget { (std::abs(targetValue - currentValue) - static_cast<F>(2) * absStep) / absStep };
+        if (!(stepsToTarget > static_cast<F>(0)))
+            return 0;
+
+        const F numSteps { std::floor(stepsToTarget + static_cast<F>(1e-3)) + static_cast<F>(1) };
+
+        return numSteps >= static_cast<F>(numSamples) ? numSamples : static_cast<unsigned int>(numSteps);
+    }
+
+    // Move the ramp state to the end of a block with numRampSamples ramping samples
+    void advance(unsigned int numRampSamples, unsigned int numSamples)
+    {
+        if (numRampSamples < numSamples)
+            currentValue = targetValue;
+        else
+            currentValue += static_cast<F>(numRampSamples) * rampStep;
+    }
+
+    // The ramp segment is evaluated in closed form from its start value,
+    // so there is no loop carried dependency and the loops vectorise
+    static void sumRamp(F* output, const F* input, F start, F step, unsigned int numSamples)
+    {
+        unsigned int n { 0 };
+        if constexpr (std::is_same_v<F, float>)
+        {
+            const SIMD::Float4 offsets { SIMD::load(stepOffsets) };
+            const SIMD::Float4 steps { offsets * SIMD::broadcast(step) };
+            for (; n + SIMD::Float4::Size <= numSamples; n += SIMD::Float4::Size)
+            {
+                const SIMD::Float4 values { SIMD::broadcast(start + static_cast<F>(n) * step) + steps };
+                SIMD::store(output + n, SIMD::load(input + n) + values);
+            }
+        }
+
+        for (; n < numSamples; ++n)
+            output[n] = input[n] + (start + static_cast<F>(n + 1) * step);
+    }
+
+    static void gainRamp(F* output, const F* input, F start, F step, unsigned int numSamples)
+    {
+        unsigned int n { 0 };
+        if constexpr (std::is_same_v<F, float>)
+        {
+            const SIMD::Float4 offsets { SIMD::load(stepOffsets) };
+            const SIMD::Float4 steps { offsets * SIMD::broadcast(step) };
+            for (; n + SIMD::Float4::Size <= numSamples; n += SIMD::Float4::Size)
+            {
+                const SIMD::Float4 values { SIMD::broadcast(start + static_cast<F>(n) * step) + steps };
+                SIMD::store(output + n, SIMD::load(input + n) * values);
+            }
+        }
+
+        for (; n < numSamples; ++n)
+            output[n] = input[n] * (start + static_cast<F>(n + 1) * step);
+    }
+
+    static void sumConstant(F* output, const F* input, F value, unsigned int numSamples)
+    {
+        unsigned int n { 0 };
+        if constexpr (std::is_same_v<F, float>)
+        {
+            const SIMD::Float4 values { SIMD::broadcast(value) };
+            for (; n + SIMD::Float4::Size <= numSamples; n += SIMD::Float4::Size)
+                SIMD::store(output + n, SIMD::load(input + n) + values);
+        }
+
+        for (; n < numSamples; ++n)
+            output[n] = input[n] + value;
+    }
+
+    static void gainConstant(F* output, const F* input, F value, unsigned int numSamples)
+    {
+        unsigned int n { 0 };
+        if constexpr (std::is_same_v<F, float>)
+        {
+            const SIMD::Float4 values { SIMD::broadcast(value) };
+            for (; n + SIMD::Float4::Size <= numSamples; n += SIMD::Float4::Size)
+                SIMD::store(output + n, SIMD::load(input + n) * values);
+        }
+
+        for (; n < numSamples; ++n)
+            output[n] = input[n] * value;
+    }
+
+    // Sample offsets of the lanes of a ramp segment, the first lane is the next sample
+    static constexpr float stepOffsets[SIMD::Float4::Size] { 1.f, 2.f, 3.f, 4.f };
+
     double sampleRate { 48000.0 };
     F rampTime;
     F rampStep { static_cast<F>(0) };
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// SSE2 is part of the x86_64 baseline and NEON of the arm64 baseline,
+// so both are always available on the architectures we build for
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define DSP_SIMD_SSE 1
+ #if defined(__F16C__)
+  #include <immintrin.h>
+ #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+ #include <arm_neon.h>
+ #define DSP_SIMD_NEON 1
+#endif
+
+namespace DSP
+{
+
+namespace SIMD
+{
+
+// Four packed single precision floats
+// Falls back to plain scalar code on targets without SSE2 or NEON
+struct Float4
+{
+    static constexpr unsigned int Size { 4 };
+
+#if defined(DSP_SIMD_SSE)
+    __m128 v;
+#elif defined(DSP_SIMD_NEON)
+    float32x4_t v;
+#else
+    float v[Size];
+#endif
+};
+
+// True if Float4 maps to hardware vector registers
+#if defined(DSP_SIMD_SSE) || defined(DSP_SIMD_NEON)
+static constexpr bool IsAccelerated { true };
+#else
+static constexpr bool IsAccelerated { false };
+#endif
+
+// Load four floats from memory, no alignment required
+inline Float4 load(const float* ptr)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_loadu_ps(ptr) };
+#elif defined(DSP_SIMD_NEON)
+    return { vld1q_f32(ptr) };
+#else
+    return { { ptr[0], ptr[1], ptr[2], ptr[3] } };
+#endif
+}
+
+// Store four floats to memory, no alignment required
+inline void store(float* ptr, Float4 a)
+{
+#if defined(DSP_SIMD_SSE)
+    _mm_storeu_ps(ptr, a.v);
+#elif defined(DSP_SIMD_NEON)
+    vst1q_f32(ptr, a.v);
+#else
+    for (unsigned int i = 0; i < Float4::Size; ++i)
+        ptr[i] = a.v[i];
+#endif
+}
+
+// Set all four lanes to the same value
+inline Float4 broadcast(float x)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_set1_ps(x) };
+#elif defined(DSP_SIMD_NEON)
+    return { vdupq_n_f32(x) };
+#else
+    return { { x, x, x, x } };
+#endif
+}
+
+inline Float4 operator+(Float4 a, Float4 b)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_add_ps(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON)
+    return { vaddq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+#endif
+}
+
+inline Float4 operator-(Float4 a, Float4 b)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_sub_ps(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON)
+    return { vsubq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+#endif
+}
+
+inline Float4 operator*(Float4 a, Float4 b)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_mul_ps(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON)
+    return { vmulq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+#endif
+}
+
+inline Float4 operator/(Float4 a, Float4 b)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_div_ps(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    return { vdivq_f32(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON)
+    // No vector divide on 32-bit ARM, refine the reciprocal estimate twice
+    float32x4_t inv { vrecpeq_f32(b.v) };
+    inv = vmulq_f32(vrecpsq_f32(b.v, inv), inv);
+    inv = vmulq_f32(vrecpsq_f32(b.v, inv), inv);
+    return { vmulq_f32(a.v, inv) };
+#else
+    return { { a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3] } };
+#endif
+}
+
+// Lane-wise minimum
+inline Float4 min(Float4 a, Float4 b)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_min_ps(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON)
+    return { vminq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1],
+               a.v[2] < b.v[2] ? a.v[2] : b.v[2], a.v[3] < b.v[3] ? a.v[3] : b.v[3] } };
+#endif
+}
+
+// Lane-wise maximum
+inline Float4 max(Float4 a, Float4 b)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_max_ps(a.v, b.v) };
+#elif defined(DSP_SIMD_NEON)
+    return { vmaxq_f32(a.v, b.v) };
+#else
+    return { { a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1],
+               a.v[2] > b.v[2] ? a.v[2] : b.v[2], a.v[3] > b.v[3] ? a.v[3] : b.v[3] } };
+#endif
+}
+
+// Lane-wise rounding towards zero, lanes must fit in a 32-bit integer
+inline Float4 truncate(Float4 a)
+{
+#if defined(DSP_SIMD_SSE)
+    return { _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v)) };
+#elif defined(DSP_SIMD_NEON)
+    return { vcvtq_f32_s32(vcvtq_s32_f32(a.v)) };
+#else
+    return { { static_cast<float>(static_cast<std::int32_t>(a.v[0])), static_cast<float>(static_cast<std::int32_t>(a.v[1])),
+               static_cast<float>(static_cast<std::int32_t>(a.v[2])), static_cast<float>(static_cast<std::int32_t>(a.v[3])) } };
+#endif
+}
+
+// Sum of the four lanes
+inline float horizontalSum(Float4 a)
+{
+#if defined(DSP_SIMD_SSE)
+    const __m128 pairs { _mm_add_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1))) };
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_movehl_ps(pairs, pairs)));
+#elif defined(DSP_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    return vaddvq_f32(a.v);
+#elif defined(DSP_SIMD_NEON)
+    const float32x2_t pairs { vadd_f32(vget_low_f32(a.v), vget_high_f32(a.v)) };
+    return vget_lane_f32(vpadd_f32(pairs, pairs), 0);
+#else
+    return (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]);
+#endif
+}
+
+// Load four signed bytes and convert them to floats
+inline Float4 loadInt8(const std::int8_t* ptr)
+{
+#if defined(DSP_SIMD_SSE)
+    std::int32_t packed;
+    std::memcpy(&packed, ptr, sizeof(packed));
+    // Replicate every byte into its 32-bit lane, the arithmetic shift sign extends it
+    __m128i x { _mm_cvtsi32_si128(packed) };
+    x = _mm_unpacklo_epi8(x, x);
+    x = _mm_unpacklo_epi16(x, x);
+    return { _mm_cvtepi32_ps(_mm_srai_epi32(x, 24)) };
+#elif defined(DSP_SIMD_NEON)
+    std::int32_t packed;
+    std::memcpy(&packed, ptr, sizeof(packed));
+    const int16x8_t x { vmovl_s8(vreinterpret_s8_s32(vdup_n_s32(packed))) };
+    return { vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))) };
+#else
+    return { { static_cast<float>(ptr[0]), static_cast<float>(ptr[1]), static_cast<float>(ptr[2]), static_cast<float>(ptr[3]) } };
+#endif
+}
+
+// Load four IEEE half precision floats, stored as raw bits, and convert them to floats
+// Only zeros and normal halves are supported, subnormals, infinities and NaNs are not
+inline Float4 loadHalf(const std::uint16_t* ptr)
+{
+#if defined(DSP_SIMD_SSE) && defined(__F16C__)
+    return { _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))) };
+#elif defined(DSP_SIMD_NEON) && (defined(__aarch64__) || defined(_M_ARM64))
+    return { vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(ptr))) };
+#elif defined(DSP_SIMD_SSE)
+    // Move exponent and mantissa into place and rebias the exponent with a multiply by 2^112
+    const __m128i h { _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)), _mm_setzero_si128()) };
+    const __m128i sign { _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x8000)), 16) };
+    const __m128i magnitude { _mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(0x7fff)), 13) };
+    const __m128 value { _mm_mul_ps(_mm_castsi128_ps(magnitude), _mm_castsi128_ps(_mm_set1_epi32(0x77800000))) };
+    return { _mm_or_ps(value, _mm_castsi128_ps(sign)) };
+#elif defined(DSP_SIMD_NEON)
+    const uint32x4_t h { vmovl_u16(vld1_u16(ptr)) };
+    const uint32x4_t sign { vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x8000)), 16) };
+    const uint32x4_t magnitude { vshlq_n_u32(vandq_u32(h, vdupq_n_u32(0x7fff)), 13) };
+    const float32x4_t value { vmulq_f32(vreinterpretq_f32_u32(magnitude), vreinterpretq_f32_u32(vdupq_n_u32(0x77800000))) };
+    return { vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(value), sign)) };
+#else
+    Float4 result;
+    for (unsigned int i = 0; i < Float4::Size; ++i)
+    {
+        const std::uint32_t magnitude { static_cast<std::uint32_t>(ptr[i] & 0x7fff) << 13 };
+        float value;
+        std::memcpy(&value, &magnitude, sizeof(value));
+        value *= 5.192296858534828e+33f; // 2^112
+        result.v[i] = (ptr[i] & 0x8000) != 0 ? -value : value;
+    }
+    return result;
+#endif
+}
+
+}
+
+}
@@ -10,7 +10,6 @@ float convertMidiNoteToFreq(int MidiNote)
 
 SynthVoice::SynthVoice()
 {
-    sawOsc.setType(Oscillator::SawAA);
     triOsc.setType(Oscillator::TriAA);
     sinOsc.setType(Oscillator::Sin);
 
@@ -42,6 +41,21 @@ void SynthVoice::setOscVol(float dB, bool skipRamp)
     oscVolRamp.setTarget(std::pow(10.f, 0.05f * dB), skipRamp);
 }
 
+void SynthVoice::setUnisonVoices(unsigned int numVoices)
+{
+    sawUnison.setNumVoices(numVoices);
+}
+
+void SynthVoice::setUnisonDetune(float cents)
+{
+    sawUnison.setDetune(cents);
+}
+
+void SynthVoice::setUnisonSpread(float norm)
+{
+    sawUnison.setSpread(norm);
+}
+
 void SynthVoice::setAttTimeVCA(float ms)
 {
     vcaEnvGen.setAttackTime(ms);
@@ -135,7 +149,8 @@ void SynthVoice::startNote(int midiNoteNumber, float newVelocity, juce::Synthesi
 {
     sinOsc.setFrequency(convertMidiNoteToFreq(midiNoteNumber));
     triOsc.setFrequency(convertMidiNoteToFreq(midiNoteNumber));
-    sawOsc.setFrequency(convertMidiNoteToFreq(midiNoteNumber));
+    sawUnison.setFrequency(convertMidiNoteToFreq(midiNoteNumber));
+    sawUnison.reset();
     vcaEnvGen.start();
     vcfEnvGen.start();
 
@@ -160,97 +175,167 @@ void SynthVoice::controllerMoved(int controllerNumber, int newControllerValue)
 {
 }
 
+void SynthVoice::setCurrentPlaybackSampleRate(double newSampleRate)
+{
+    juce::SynthesiserVoice::setCurrentPlaybackSampleRate(newSampleRate);
+    if (sampleRate == newSampleRate)
+        return;
+
+    // Prepared here rather than on the first render, only active voices are rendered
+    sampleRate = newSampleRate;
+
+    sinOsc.prepare(sampleRate);
+    triOsc.prepare(sampleRate);
+    sawUnison.prepare(sampleRate);
+    vcaEnvGen.prepare(sampleRate);
+    vcfEnvGen.prepare(sampleRate);
+    filter.prepare(sampleRate);
+    filterRight.prepare(sampleRate);
+    sinOscVolRamp.prepare(sampleRate);
+    triOscVolRamp.prepare(sampleRate);
+    sawOscVolRamp.prepare(sampleRate);
+    oscVolRamp.prepare(sampleRate);
+    outputVolRamp.prepare(sampleRate);
+    vcfEnvAmountRamp.prepare(sampleRate);
+    vcfLFOAmountRamp.prepare(sampleRate);
+    vcfFreqRamp.prepare(sampleRate);
+    vcfResoRamp.prepare(sampleRate);
+    vcfLPFRamp.prepare(sampleRate);
+    vcfBPFRamp.prepare(sampleRate);
+    vcfHPFRamp.prepare(sampleRate);
+
+    lfoPhaseInc = static_cast<float>(2.0 * M_PI / sampleRate) * std::fmax(lfoFreq, 0.f);
+}
+
 void SynthVoice::renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples)
 {
-    const auto newSampleRate { getSampleRate() };
-    if (sampleRate != newSampleRate)
+    // Render in sub-blocks into the scratch buffers of the voice, every module runs over the whole sub-block
+    while (numSamples > 0)
     {
-        sampleRate = newSampleRate;
-
-        sinOsc.prepare(sampleRate);
-        triOsc.prepare(sampleRate);
-        sawOsc.prepare(sampleRate);
-        vcaEnvGen.prepare(sampleRate);
-        vcfEnvGen.prepare(sampleRate);
-        filter.prepare(sampleRate);
-        sinOscVolRamp.prepare(sampleRate);
-        triOscVolRamp.prepare(sampleRate);
-        sawOscVolRamp.prepare(sampleRate);
-        oscVolRamp.prepare(sampleRate);
-        outputVolRamp.prepare(sampleRate);
-        vcfEnvAmountRamp.prepare(sampleRate);
-        vcfLFOAmountRamp.prepare(sampleRate);
-        vcfFreqRamp.prepare(sampleRate);
-        vcfResoRamp.prepare(sampleRate);
-        vcfLPFRamp.prepare(sampleRate);
-        vcfBPFRamp.prepare(sampleRate);
-        vcfHPFRamp.prepare(sampleRate);
-
-        lfoPhaseInc = static_cast<float>(2.0 * M_PI / sampleRate) * std::fmax(lfoFreq, 0.f);
-    }
+        const unsigned int subBlockSize { static_cast<unsigned int>(std::min(numSamples, static_cast<int>(SubBlockSize))) };
+        renderSubBlock(subBlockSize);
 
-    for (int i = 0; i < numSamples; ++i)
-    {
-        const auto sin { sinOsc.process() };
-        const auto tri { triOsc.process() };
-        const auto saw { sawOsc.process() };
+        // Mono outputs get the sum of both sides
+        if (outputBuffer.getNumChannels() == 1)
+        {
+            outputBuffer.addFrom(0, startSample, leftBuffer, static_cast<int>(subBlockSize), 0.5f);
+            outputBuffer.addFrom(0, startSample, rightBuffer, static_cast<int>(subBlockSize), 0.5f);
+        }
+        else
+        {
+            for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
+                outputBuffer.addFrom(ch, startSample, ch % 2 == 0 ? leftBuffer : rightBuffer, static_cast<int>(subBlockSize));
+        }
 
-        float vcaEnv { 0.f };
-        vcaEnvGen.process(&vcaEnv, 1);
+        startSample += static_cast<int>(subBlockSize);
+        numSamples -= static_cast<int>(subBlockSize);
 
-        float vcfEnv { 0.f };
-        vcfEnvGen.process(&vcfEnv, 1);
+        // Checked once per sub-block, the envelopes are silent from the sample they turned off
+        if (voiceStarted && vcaEnvGen.isOff() && vcfEnvGen.isOff())
+        {
+            voiceStarted = false;
+            clearCurrentNote();
+            break;
+        }
+    }
+}
 
-        const auto sinVol { sinOscVolRamp.getNext() };
-        const auto triVol { triOscVolRamp.getNext() };
-        const auto sawVol { sawOscVolRamp.getNext() };
-        const auto oscVol { oscVolRamp.getNext() };
+void SynthVoice::renderSubBlock(unsigned int numSamples)
+{
+    float* const sinChannel[] { sinBuffer };
+    float* const triChannel[] { triBuffer };
+    float* const vcaEnvChannel[] { vcaEnvBuffer };
+    float* const stereoChannels[] { leftBuffer, rightBuffer };
+
+    // Oscillators, each with its volume
+    sinOsc.process(sinBuffer, numSamples);
+    triOsc.process(triBuffer, numSamples);
+    sawUnison.process(leftBuffer, rightBuffer, numSamples);
+
+    sinOscVolRamp.applyGain(sinChannel, 1, numSamples);
+    triOscVolRamp.applyGain(triChannel, 1, numSamples);
+    sawOscVolRamp.applyGain(stereoChannels, 2, numSamples);
+
+    // Envelopes, the oscillator volume is folded into the VCA envelope
+    vcaEnvGen.process(vcaEnvBuffer, numSamples);
+    vcfEnvGen.process(vcfEnvBuffer, numSamples);
+    oscVolRamp.applyGain(vcaEnvChannel, 1, numSamples);
+
+    for (unsigned int n = 0; n < numSamples; ++n)
+    {
+        const float oscMono { sinBuffer[n] + triBuffer[n] };
+        const float oscGain { vcaEnvBuffer[n] * velocity };
+        leftBuffer[n] = (leftBuffer[n] + oscMono) * oscGain;
+        rightBuffer[n] = (rightBuffer[n] + oscMono) * oscGain;
+    }
 
-        const auto vcfEnvAmout { vcfEnvAmountRamp.getNext() };
-        const auto vcfLFOAmount { vcfLFOAmountRamp.getNext() };
+    // Filter
+    vcfFreqRamp.getNext(freqBuffer, numSamples);
+    vcfResoRamp.getNext(resoBuffer, numSamples);
+    processCutoffModulation(numSamples);
 
-        const auto vcfFreq { vcfFreqRamp.getNext() };
-        const auto vcfReso { vcfResoRamp.getNext() };
-        const auto vcfLPF { vcfLPFRamp.getNext() };
-        const auto vcfBPF { vcfBPFRamp.getNext() };
-        const auto vcfHPF { vcfHPFRamp.getNext() };
+    filter.process(lpfBuffer[0], bpfBuffer[0], hpfBuffer[0], leftBuffer, freqBuffer, resoBuffer, numSamples);
+    filterRight.process(lpfBuffer[1], bpfBuffer[1], hpfBuffer[1], rightBuffer, freqBuffer, resoBuffer, numSamples);
 
-        const auto outputVol { outputVolRamp.getNext() };
+    // Filter type crossfade and output volume
+    float* const lpfChannels[] { lpfBuffer[0], lpfBuffer[1] };
+    float* const bpfChannels[] { bpfBuffer[0], bpfBuffer[1] };
+    float* const hpfChannels[] { hpfBuffer[0], hpfBuffer[1] };
+    vcfLPFRamp.applyGain(lpfChannels, 2, numSamples);
+    vcfBPFRamp.applyGain(bpfChannels, 2, numSamples);
+    vcfHPFRamp.applyGain(hpfChannels, 2, numSamples);
 
-        // Process LFO acording to mod type
-        float lfo { 0.f };
-        switch (lfoType)
-        {
-        case TRI:
-            lfo = std::fabs((lfoPhaseState - static_cast<float>(M_PI)) / static_cast<float>(M_PI));
-            break;
+    for (unsigned int n = 0; n < numSamples; ++n)
+    {
+        leftBuffer[n] = lpfBuffer[0][n] + bpfBuffer[0][n] + hpfBuffer[0][n];
+        rightBuffer[n] = lpfBuffer[1][n] + bpfBuffer[1][n] + hpfBuffer[1][n];
+    }
 
-        case SIN:
-            lfo = 0.5f + 0.5f * std::sin(lfoPhaseState);
-            break;
-        }
-        lfoPhaseState = std::fmod(lfoPhaseState + lfoPhaseInc, static_cast<float>(2 * M_PI));
+    outputVolRamp.applyGain(stereoChannels, 2, numSamples);
+}
 
-        const auto oscOut { (sin * sinVol + tri * triVol + saw * sawVol) * oscVol * vcaEnv * velocity };
-        const auto freqMod { std::clamp(vcfEnv * vcfEnvAmout + vcfLFOAmount * lfo, -1.f, 1.f) };
-        const auto freq { std::clamp(FreqModRange * (std::pow(2.f, freqMod) - 1.f) + vcfFreq, MinFreqHz, MaxFreqHz) };
+void SynthVoice::processCutoffModulation(unsigned int numSamples)
+{
+    constexpr float twoPi { static_cast<float>(2 * M_PI) };
 
-        float lpfOut { 0.f };
-        float bpfOut { 0.f };
-        float hpfOut { 0.f };
-        filter.process(&lpfOut, &bpfOut, &hpfOut, &oscOut, &freq, &vcfReso, 1);
+    // Without modulation the cutoff is the ramp alone, skip the LFO and the exponential
+    const bool isModulated { vcfEnvAmountRamp.getCurrent() != 0.f || vcfEnvAmountRamp.getTarget() != 0.f
+                          || vcfLFOAmountRamp.getCurrent() != 0.f || vcfLFOAmountRamp.getTarget() != 0.f };
+    if (!isModulated)
+    {
+        lfoPhaseState = std::fmod(lfoPhaseState + static_cast<float>(numSamples) * lfoPhaseInc, twoPi);
+        return;
+    }
 
-        const auto out { (vcfLPF * lpfOut + vcfBPF * bpfOut + vcfHPF * hpfOut) * outputVol };
-        for (int ch = 0; ch < outputBuffer.getNumChannels(); ++ch)
+    // Process LFO acording to mod type, the type is fixed for the whole sub-block
+    switch (lfoType)
+    {
+    case TRI:
+        for (unsigned int n = 0; n < numSamples; ++n)
         {
-            outputBuffer.addSample(ch, startSample + i, out);
+            lfoBuffer[n] = std::fabs((lfoPhaseState - static_cast<float>(M_PI)) / static_cast<float>(M_PI));
+            lfoPhaseState += lfoPhaseInc;
+            lfoPhaseState -= static_cast<float>(lfoPhaseState >= twoPi) * twoPi;
         }
+        break;
 
-        if (voiceStarted && vcaEnvGen.isOff() && vcfEnvGen.isOff())
+    case SIN:
+        for (unsigned int n = 0; n < numSamples; ++n)
         {
-            voiceStarted = false;
-            clearCurrentNote();
+            lfoBuffer[n] = 0.5f + 0.5f * std::sin(lfoPhaseState);
+            lfoPhaseState += lfoPhaseInc;
+            lfoPhaseState -= static_cast<float>(lfoPhaseState >= twoPi) * twoPi;
         }
+        break;
+    }
+
+    vcfEnvAmountRamp.getNext(envAmountBuffer, numSamples);
+    vcfLFOAmountRamp.getNext(lfoAmountBuffer, numSamples);
+
+    for (unsigned int n = 0; n < numSamples; ++n)
+    {
+        const float freqMod { std::clamp(vcfEnvBuffer[n] * envAmountBuffer[n] + lfoAmountBuffer[n] * lfoBuffer[n], -1.f, 1.f) };
+        freqBuffer[n] = std::clamp(FreqModRange * (std::exp2(freqMod) - 1.f) + freqBuffer[n], MinFreqHz, MaxFreqHz);
     }
 }
 
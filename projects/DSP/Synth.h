@@ -3,6 +3,7 @@
 #include <JuceHeader.h>
 
 #include "Oscillator.h"
+#include "UnisonOscillator.h"
 #include "EnvelopeGenerator.h"
 #include "StateVariableFilter.h"
 #include "Ramp.h"
@@ -49,6 +50,10 @@ public:
     void setOscSinVol(float dB, bool skipRamp);
     void setOscVol(float dB, bool skipRamp);
 
+    void setUnisonVoices(unsigned int numVoices);
+    void setUnisonDetune(float cents);
+    void setUnisonSpread(float norm);
+
     void setAttTimeVCA(float ms);
     void setDecayTimeVCA(float ms);
     void setSustainVCA(float norm);
@@ -78,6 +83,7 @@ public:
     void pitchWheelMoved(int newPitchWheelValue) override;
     void controllerMoved(int controllerNumber, int newControllerValue) override;
     void renderNextBlock(juce::AudioBuffer<float>& outputBuffer, int startSample, int numSamples) override;
+    void setCurrentPlaybackSampleRate(double newSampleRate) override;
 
     static constexpr float MaxFreqHz { 20000.f };
     static constexpr float MinFreqHz { 20.f };
@@ -95,12 +101,15 @@ private:
 
     Oscillator sinOsc;
     Oscillator triOsc;
-    Oscillator sawOsc;
+
+    // The saw runs as a stereo unison bank, with a single voice it is a plain PolyBLEP saw
+    UnisonOscillator sawUnison;
 
     EnvelopeGenerator vcaEnvGen;
     EnvelopeGenerator vcfEnvGen;
 
     StateVariableFilter filter;
+    StateVariableFilter filterRight;
 
     LFOType lfoType;
     float lfoPhaseState { 0.f };
@@ -122,6 +131,30 @@ private:
     Ramp<float> vcfHPFRamp;
 
     bool voiceStarted { false };
+
+    // Scratch buffers of one sub-block, preallocated with the voice so rendering never allocates
+    static constexpr unsigned int SubBlockSize { 64 };
+
+    alignas(16) float sinBuffer[SubBlockSize];
+    alignas(16) float triBuffer[SubBlockSize];
+    alignas(16) float leftBuffer[SubBlockSize];
+    alignas(16) float rightBuffer[SubBlockSize];
+    alignas(16) float vcaEnvBuffer[SubBlockSize];
+    alignas(16) float vcfEnvBuffer[SubBlockSize];
+    alignas(16) float lfoBuffer[SubBlockSize];
+    alignas(16) float envAmountBuffer[SubBlockSize];
+    alignas(16) float lfoAmountBuffer[SubBlockSize];
+    alignas(16) float freqBuffer[SubBlockSize];
+    alignas(16) float resoBuffer[SubBlockSize];
+    alignas(16) float lpfBuffer[2][SubBlockSize];
+    alignas(16) float bpfBuffer[2][SubBlockSize];
+    alignas(16) float hpfBuffer[2][SubBlockSize];
+
+    // Render up to SubBlockSize samples into leftBuffer and rightBuffer
+    void renderSubBlock(unsigned int numSamples);
+
+    // Add the envelope and LFO modulation to the cutoff in freqBuffer
+    void processCutoffModulation(unsigned int numSamples);
 };
 
 }
@@ -0,0 +1,164 @@
+#include "UnisonOscillator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DSP
+{
+
+// One sample of four PolyBLEP saws, branch free
+// a is 1 - p / dt right after the wrap and b is 1 - (1 - p) / dt right before it, both are 0 elsewhere,
+// lanes with a zero inverse increment get a = b = 1, which cancels out
+static inline SIMD::Float4 polyBlepSaw(SIMD::Float4 phase, SIMD::Float4 invPhaseInc)
+{
+    const SIMD::Float4 zero { SIMD::broadcast(0.f) };
+    const SIMD::Float4 one { SIMD::broadcast(1.f) };
+    const SIMD::Float4 a { SIMD::max(zero, one - phase * invPhaseInc) };
+    const SIMD::Float4 b { SIMD::max(zero, one - (one - phase) * invPhaseInc) };
+    return phase + phase - one + a * a - b * b;
+}
+
+UnisonOscillator::UnisonOscillator()
+{
+    updateRatios();
+    updateGains();
+    reset();
+}
+
+UnisonOscillator::~UnisonOscillator()
+{
+}
+
+void UnisonOscillator::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    updatePhaseIncs();
+    reset();
+}
+
+void UnisonOscillator::reset()
+{
+    // Start the copies on evenly scattered phases, in phase copies would sum into a comb filtered burst
+    for (unsigned int i = 0; i < MaxVoices; ++i)
+    {
+        const float phase { 0.618034f * static_cast<float>(i) };
+        phases[i] = phase - std::floor(phase);
+    }
+}
+
+void UnisonOscillator::process(float* left, float* right, unsigned int numSamples)
+{
+    // Keep the state of the active groups in registers for the whole buffer
+    SIMD::Float4 phase[NumGroups];
+    SIMD::Float4 phaseInc[NumGroups];
+    SIMD::Float4 invPhaseInc[NumGroups];
+    SIMD::Float4 gainLeft[NumGroups];
+    SIMD::Float4 gainRight[NumGroups];
+    for (unsigned int g = 0; g < numGroups; ++g)
+    {
+        const unsigned int offset { g * SIMD::Float4::Size };
+        phase[g] = SIMD::load(phases + offset);
+        phaseInc[g] = SIMD::load(phaseIncs + offset);
+        invPhaseInc[g] = SIMD::load(invPhaseIncs + offset);
+        gainLeft[g] = SIMD::load(gainsLeft + offset);
+        gainRight[g] = SIMD::load(gainsRight + offset);
+    }
+
+    for (unsigned int n = 0; n < numSamples; ++n)
+    {
+        SIMD::Float4 sumLeft { SIMD::broadcast(0.f) };
+        SIMD::Float4 sumRight { SIMD::broadcast(0.f) };
+        for (unsigned int g = 0; g < numGroups; ++g)
+        {
+            const SIMD::Float4 saw { polyBlepSaw(phase[g], invPhaseInc[g]) };
+            sumLeft = sumLeft + saw * gainLeft[g];
+            sumRight = sumRight + saw * gainRight[g];
+
+            // Wrap around, phaseInc is below 1
+            const SIMD::Float4 next { phase[g] + phaseInc[g] };
+            phase[g] = next - SIMD::truncate(next);
+        }
+
+        // Reduce the lanes once per sample, not once per group
+        left[n] = SIMD::horizontalSum(sumLeft);
+        right[n] = SIMD::horizontalSum(sumRight);
+    }
+
+    for (unsigned int g = 0; g < numGroups; ++g)
+        SIMD::store(phases + g * SIMD::Float4::Size, phase[g]);
+}
+
+void UnisonOscillator::process(float& left, float& right)
+{
+    process(&left, &right, 1);
+}
+
+void UnisonOscillator::setFrequency(float freqHz)
+{
+    frequency = std::fmax(freqHz, 0.f);
+    updatePhaseIncs();
+}
+
+void UnisonOscillator::setNumVoices(unsigned int newNumVoices)
+{
+    newNumVoices = std::clamp(newNumVoices, 1u, MaxVoices);
+    if (newNumVoices == numVoices)
+        return;
+
+    numVoices = newNumVoices;
+    numGroups = (numVoices + SIMD::Float4::Size - 1) / SIMD::Float4::Size;
+
+    updateRatios();
+    updatePhaseIncs();
+    updateGains();
+}
+
+void UnisonOscillator::setDetune(float cents)
+{
+    detune = std::fmax(cents, 0.f);
+    updateRatios();
+    updatePhaseIncs();
+}
+
+void UnisonOscillator::setSpread(float newSpread)
+{
+    spread = std::clamp(newSpread, 0.f, 1.f);
+    updateGains();
+}
+
+float UnisonOscillator::getPosition(unsigned int i) const
+{
+    // A single copy stays centred
+    return numVoices > 1 ? 2.f * static_cast<float>(i) / static_cast<float>(numVoices - 1) - 1.f : 0.f;
+}
+
+void UnisonOscillator::updateRatios()
+{
+    for (unsigned int i = 0; i < MaxVoices; ++i)
+        ratios[i] = i < numVoices ? std::exp2(detune * getPosition(i) / 1200.f) : 0.f;
+}
+
+void UnisonOscillator::updatePhaseIncs()
+{
+    const float baseInc { static_cast<float>(1.0 / sampleRate) * frequency };
+    for (unsigned int i = 0; i < MaxVoices; ++i)
+    {
+        // The two sample residual needs a period of at least two samples
+        phaseIncs[i] = std::fmin(baseInc * ratios[i], 0.5f);
+        invPhaseIncs[i] = phaseIncs[i] > 0.f ? 1.f / phaseIncs[i] : 0.f;
+    }
+}
+
+void UnisonOscillator::updateGains()
+{
+    // Uncorrelated copies add up in power, keep the level of a single copy
+    const float norm { 1.f / std::sqrt(static_cast<float>(numVoices)) };
+    for (unsigned int i = 0; i < MaxVoices; ++i)
+    {
+        // Balance law, a centred copy plays at full level on both sides
+        const float pan { spread * getPosition(i) };
+        gainsLeft[i] = i < numVoices ? norm * std::fmin(1.f, 1.f - pan) : 0.f;
+        gainsRight[i] = i < numVoices ? norm * std::fmin(1.f, 1.f + pan) : 0.f;
+    }
+}
+
+}
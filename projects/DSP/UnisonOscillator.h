@@ -0,0 +1,74 @@
+#pragma once
+
+#include "SIMD.h"
+
+namespace DSP
+{
+
+// Bank of detuned PolyBLEP saws spread across the stereo field
+// Every detuned copy runs in its own SIMD lane, so a group of four copies costs about as much as one
+class UnisonOscillator
+{
+public:
+    static constexpr unsigned int MaxVoices { 16 };
+
+    UnisonOscillator();
+    ~UnisonOscillator();
+
+    UnisonOscillator(const UnisonOscillator&) = delete;
+    UnisonOscillator(UnisonOscillator&&) = delete;
+    const UnisonOscillator& operator=(const UnisonOscillator&) = delete;
+    const UnisonOscillator& operator=(UnisonOscillator&&) = delete;
+
+    // Update new sample rate
+    void prepare(double sampleRate);
+
+    // Restart the copies on their spread start phases, call on note on
+    void reset();
+
+    // Render the bank output of a buffer into the left and right channels
+    void process(float* left, float* right, unsigned int numSamples);
+
+    // Process a single sample of the bank
+    void process(float& left, float& right);
+
+    // Set the frequency of the centre copy in Hz, cheap enough for per block pitch modulation
+    void setFrequency(float freqHz);
+
+    // Number of detuned copies, from 1 to MaxVoices
+    void setNumVoices(unsigned int numVoices);
+
+    // Detune of the outermost copies in cents, the others are spread evenly in between
+    void setDetune(float cents);
+
+    // Stereo spread of the outermost copies, from 0 (mono) to 1 (hard left and right)
+    void setSpread(float spread);
+
+private:
+    static constexpr unsigned int NumGroups { MaxVoices / SIMD::Float4::Size };
+
+    double sampleRate { 48000.0 };
+
+    float frequency { 1.f };
+    unsigned int numVoices { 1 };
+    unsigned int numGroups { 1 };
+    float detune { 0.f };
+    float spread { 0.f };
+
+    // Per copy state, unused lanes have zero increment and gain and add nothing
+    alignas(16) float phases[MaxVoices] { };
+    alignas(16) float phaseIncs[MaxVoices] { };
+    alignas(16) float invPhaseIncs[MaxVoices] { };
+    alignas(16) float ratios[MaxVoices] { };
+    alignas(16) float gainsLeft[MaxVoices] { };
+    alignas(16) float gainsRight[MaxVoices] { };
+
+    // Position of copy i in the detune and stereo range, from -1 to 1
+    float getPosition(unsigned int i) const;
+
+    void updateRatios();
+    void updatePhaseIncs();
+    void updateGains();
+};
+
+}
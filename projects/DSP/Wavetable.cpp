@@ -0,0 +1,123 @@
+#include "Wavetable.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace DSP
+{
+
+const Wavetable& Wavetable::get(Shape shape)
+{
+    static const Wavetable sine { Sine };
+    static const Wavetable saw { Saw };
+    static const Wavetable triangle { Triangle };
+    static const Wavetable square { Square };
+
+    switch (shape)
+    {
+    case Saw: return saw;
+    case Triangle: return triangle;
+    case Square: return square;
+    default: return sine;
+    }
+}
+
+Wavetable::Wavetable(Shape shape) :
+    tables(NumTables * (TableSize + 1), 0.f)
+{
+    // Harmonic k at sample i is sinTable[(k * i) % TableSize], exact and without calls to std::sin
+    std::vector<double> sinTable(TableSize);
+    for (unsigned int i = 0; i < TableSize; ++i)
+        sinTable[i] = std::sin(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(TableSize));
+
+    std::vector<double> cycle(TableSize);
+    for (unsigned int t = 0; t < NumTables; ++t)
+    {
+        const unsigned int numHarmonics { shape == Sine ? 1 : MaxHarmonics >> t };
+        std::fill(cycle.begin(), cycle.end(), 0.0);
+
+        // Sum from the highest harmonic down so the small terms are not lost
+        for (unsigned int k = numHarmonics; k >= 1; --k)
+        {
+            double gain { 0.0 };
+            unsigned int offset { 0 };
+
+            switch (shape)
+            {
+            case Sine:
+                gain = 1.0;
+                break;
+
+            case Saw:
+                // rising ramp 2 * phase - 1
+                gain = -2.0 / (M_PI * k);
+                break;
+
+            case Triangle:
+                // 4 * |phase - 0.5| - 1, a cosine series of odd harmonics
+                gain = (k % 2 == 1) ? 8.0 / (M_PI * M_PI * k * k) : 0.0;
+                offset = TableSize / 4;
+                break;
+
+            case Square:
+                gain = (k % 2 == 1) ? 4.0 / (M_PI * k) : 0.0;
+                break;
+
+            default: break;
+            }
+
+            if (gain == 0.0)
+                continue;
+
+            for (unsigned int i = 0; i < TableSize; ++i)
+                cycle[i] += gain * sinTable[(k * i + offset) % TableSize];
+        }
+
+        float* table { tables.data() + t * (TableSize + 1) };
+        for (unsigned int i = 0; i < TableSize; ++i)
+            table[i] = static_cast<float>(cycle[i]);
+        table[TableSize] = table[0];
+    }
+}
+
+const float* Wavetable::getTable(float phaseInc) const
+{
+    unsigned int t { 0 };
+    float maxPhaseInc { 0.5f / static_cast<float>(MaxHarmonics) };
+    while (t < NumTables - 1 && phaseInc > maxPhaseInc)
+    {
+        maxPhaseInc *= 2.f;
+        ++t;
+    }
+    return tables.data() + t * (TableSize + 1);
+}
+
+void Wavetable::process(const float* table, float* output, unsigned int numSamples, float& phase, float phaseInc)
+{
+    const float size { static_cast<float>(TableSize) };
+    float p { phase };
+
+    for (unsigned int n = 0; n < numSamples; ++n)
+    {
+        const float index { p * size };
+        const unsigned int i { static_cast<unsigned int>(index) };
+        const float frac { index - static_cast<float>(i) };
+        output[n] = table[i] + frac * (table[i + 1] - table[i]);
+
+        // Branchless wrap, phases are positive so truncation is floor
+        // and any increment wraps back into [0, 1)
+        p += phaseInc;
+        p -= static_cast<float>(static_cast<int>(p));
+    }
+
+    phase = p;
+}
+
+float Wavetable::process(const float* table, float& phase, float phaseInc)
+{
+    float output;
+    process(table, &output, 1, phase, phaseInc);
+    return output;
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+namespace DSP
+{
+
+// Band-limited single cycle tables, one per octave of the fundamental
+// Table t holds the harmonics that stay below Nyquist for phase increments up to 2^t / 1024,
+// so the table picked for a frequency never aliases, apart from the interpolation error
+class Wavetable
+{
+public:
+    enum Shape : unsigned int
+    {
+        Sine = 0,
+        Saw,
+        Triangle,
+        Square,
+        NumShapes
+    };
+
+    // Samples per cycle, every table has one extra guard sample for the interpolation
+    static constexpr unsigned int TableSize { 2048 };
+
+    // Harmonics of the lowest table, halved for every following one down to a single sine
+    static constexpr unsigned int MaxHarmonics { 512 };
+    static constexpr unsigned int NumTables { 10 };
+
+    // Shared tables of a shape, built on first use
+    // Call once outside of the audio thread so the tables are ready before processing
+    static const Wavetable& get(Shape shape);
+
+    // Table for a phase increment in cycles per sample
+    const float* getTable(float phaseInc) const;
+
+    // Render numSamples with linear interpolation, phase is in [0, 1) and advances by phaseInc
+    static void process(const float* table, float* output, unsigned int numSamples, float& phase, float phaseInc);
+
+    // Render a single sample
+    static float process(const float* table, float& phase, float phaseInc);
+
+    // No copy semantics
+    Wavetable(const Wavetable&) = delete;
+    const Wavetable& operator=(const Wavetable&) = delete;
+
+    // No move semantics
+    Wavetable(Wavetable&&) = delete;
+    const Wavetable& operator=(Wavetable&&) = delete;
+
+private:
+    explicit Wavetable(Shape shape);
+
+    std::vector<float> tables;
+};
+
+}
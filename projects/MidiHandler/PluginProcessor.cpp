@@ -32,6 +32,8 @@ MidiHandlerAudioProcessor::MidiHandlerAudioProcessor() :
         DSP::Oscillator::OscType type = static_cast<DSP::Oscillator::OscType>(std::rint(value));
         voice->setWaveType(type);
     });
+
+    attRelTimeIndex = paramManager.getParameterIndex(Param::ID::AttRelTime);
 }
 
 MidiHandlerAudioProcessor::~MidiHandlerAudioProcessor()
@@ -51,9 +53,24 @@ void MidiHandlerAudioProcessor::releaseResources()
 void MidiHandlerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    paramManager.updateParameters();
 
-    synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
+    // The controller drives the voice directly, the parameter itself and its knob stay where they are
+    for (const auto metadata : midiMessages)
+    {
+        const juce::MidiMessage message { metadata.getMessage() };
+        if (message.isController() && message.getControllerNumber() == Param::MIDI::AttRelTimeCC)
+        {
+            const float value { attRelTimeRange.convertFrom0to1(static_cast<float>(message.getControllerValue()) / 127.f) };
+            paramManager.addTimedParameterChange(attRelTimeIndex, attRelTimeRange.snapToLegalValue(value), metadata.samplePosition);
+        }
+    }
+
+    // The synth handles the notes of each sub-block itself, from the same MIDI buffer
+    paramManager.processSubBlocks(buffer.getNumSamples(), MaxSubBlockSize,
+    [this, &buffer, &midiMessages] (int startSample, int numSamples)
+    {
+        synth.renderNextBlock(buffer, midiMessages, startSample, numSamples);
+    });
 }
 
 void MidiHandlerAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
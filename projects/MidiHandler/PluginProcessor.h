@@ -27,7 +27,13 @@ namespace Param
         static constexpr float AttRelTimeInc { 0.1f };
         static constexpr float AttRelTimeSkw { 0.5f };
 
-        static const juce::StringArray WaveType { "Sine", "Tri. Aliased", "Saw Aliased", "Tri. AA", "Saw AA" };
+        static const juce::StringArray WaveType { "Sine", "Tri. Aliased", "Saw Aliased", "Tri. AA", "Saw AA", "Saw WT", "Tri. WT", "Square WT", "Saw BLEP", "Square BLEP", "Pulse BLEP" };
+    }
+
+    namespace MIDI
+    {
+        // Sound controller 4, attack time in General MIDI 2
+        static constexpr int AttRelTimeCC { 73 };
     }
 }
 
@@ -66,5 +72,12 @@ private:
     juce::Synthesiser synth;
     DSP::SynthVoice* voice { nullptr };
 
+    // Controller changes are applied at their sample position, the block is rendered
+    // in sub-blocks between them, and at most this long so host changes are not held back
+    static constexpr int MaxSubBlockSize { 256 };
+    int attRelTimeIndex { -1 };
+    const juce::NormalisableRange<float> attRelTimeRange { Param::Ranges::AttRelTimeMin, Param::Ranges::AttRelTimeMax,
+                                                           Param::Ranges::AttRelTimeInc, Param::Ranges::AttRelTimeSkw };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiHandlerAudioProcessor)
 };
\ No newline at end of file
@@ -21,7 +21,7 @@ static std::vector<mrta::ParameterInfo> parameters
 
 ParametricEQAudioProcessor::ParametricEQAudioProcessor() :
     parameterManager(*this, ProjectInfo::projectName, parameters),
-    eq(3)
+    eq(3, 2, DSP::ParametricEqualizer::TransposedDirectForm2)
 {
     parameterManager.registerParameterCallback(Param::ID::Band0Type,
     [this] (float val, bool /*force*/)
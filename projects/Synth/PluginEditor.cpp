@@ -3,23 +3,27 @@
 SynthAudioProcessorEditor::SynthAudioProcessorEditor(SynthAudioProcessor& p) :
     juce::AudioProcessorEditor(p), audioProcessor(p),
     oscParamEditor(p.getParamManager(), PARAM_HEIGHT, { Param::ID::OscillatorSawVol, Param::ID::OscillatorTriVol, Param::ID::OscillatorSinVol, Param::ID::OscillatorVol, Param::ID::OutputVol }),
+    unisonParamEditor(p.getParamManager(), PARAM_HEIGHT, { Param::ID::UnisonVoices, Param::ID::UnisonDetune, Param::ID::UnisonSpread }),
     vcaEnvParamEditor(p.getParamManager(), PARAM_HEIGHT, { Param::ID::VCA_AttTime, Param::ID::VCA_DecayTime, Param::ID::VCA_Sustain, Param::ID::VCA_RelTime }),
     vcfEnvParamEditor(p.getParamManager(), PARAM_HEIGHT, { Param::ID::VCF_AttTime, Param::ID::VCF_DecayTime, Param::ID::VCF_Sustain, Param::ID::VCF_RelTime }),
     lfoParamEditor(p.getParamManager(), PARAM_HEIGHT, { Param::ID::VCF_LFOFreq, Param::ID::VCF_LFOType }),
     filterParamEditor(p.getParamManager(), PARAM_HEIGHT, { Param::ID::VCF_Cutoff, Param::ID::VCF_Reso, Param::ID::VCF_Type, Param::ID::VCF_EnvAmount, Param::ID::VCF_LFOAmount }),
     oscLabel("", "Oscillators"),
+    unisonLabel("", "Saw Unison"),
     vcaEnvLabel("", "Amplitude Envelope"),
     vcfEnvLabel("", "Filter Envelope"),
     lfoLabel("", "Filter LFO"),
     filterLabel("", "Filter")
 {
     addAndMakeVisible(oscParamEditor);
+    addAndMakeVisible(unisonParamEditor);
     addAndMakeVisible(vcaEnvParamEditor);
     addAndMakeVisible(vcfEnvParamEditor);
     addAndMakeVisible(lfoParamEditor);
     addAndMakeVisible(filterParamEditor);
 
     setupLabel(oscLabel);
+    setupLabel(unisonLabel);
     setupLabel(vcaEnvLabel);
     setupLabel(vcfEnvLabel);
     setupLabel(lfoLabel);
@@ -49,6 +53,12 @@ void SynthAudioProcessorEditor::resized()
         oscParamEditor.setBounds(secBounds.withSizeKeepingCentre(SECTION_WIDTH, secBounds.getHeight()));
     }
 
+    {
+        auto secBounds { bounds.removeFromLeft(SECTION_WIDTH + SECTION_SPACER_WIDTH / 2) };
+        unisonLabel.setBounds(secBounds.removeFromTop(LABEL_HEIGHT));
+        unisonParamEditor.setBounds(secBounds.withSizeKeepingCentre(SECTION_WIDTH, secBounds.getHeight()));
+    }
+
     {
         auto secBounds { bounds.removeFromLeft(SECTION_WIDTH + SECTION_SPACER_WIDTH / 2) };
         vcaEnvLabel.setBounds(secBounds.removeFromTop(LABEL_HEIGHT));
@@ -11,7 +11,7 @@ public:
     void paint(juce::Graphics&) override;
     void resized() override;
 
-    static constexpr int NUM_SECTIONS { 5 };
+    static constexpr int NUM_SECTIONS { 6 };
     static constexpr int SECTION_WIDTH { 250 };
     static constexpr int SECTION_SPACER_WIDTH { 20 };
     static constexpr int LABEL_HEIGHT { 50 };
@@ -21,12 +21,14 @@ public:
 private:
     SynthAudioProcessor& audioProcessor;
     mrta::GenericParameterEditor oscParamEditor;
+    mrta::GenericParameterEditor unisonParamEditor;
     mrta::GenericParameterEditor vcaEnvParamEditor;
     mrta::GenericParameterEditor vcfEnvParamEditor;
     mrta::GenericParameterEditor lfoParamEditor;
     mrta::GenericParameterEditor filterParamEditor;
 
     juce::Label oscLabel;
+    juce::Label unisonLabel;
     juce::Label vcaEnvLabel;
     juce::Label vcfEnvLabel;
     juce::Label lfoLabel;
@@ -21,6 +21,21 @@ void setOscVol(std::vector<DSP::SynthVoice*> voices, float dB, bool skipRamp)
     std::for_each(voices.begin(), voices.end(), [dB, skipRamp] (auto& v) { v->setOscVol(dB, skipRamp); });
 }
 
+void setUnisonVoices(std::vector<DSP::SynthVoice*> voices, unsigned int numVoices)
+{
+    std::for_each(voices.begin(), voices.end(), [numVoices] (auto& v) { v->setUnisonVoices(numVoices); });
+}
+
+void setUnisonDetune(std::vector<DSP::SynthVoice*> voices, float cents)
+{
+    std::for_each(voices.begin(), voices.end(), [cents] (auto& v) { v->setUnisonDetune(cents); });
+}
+
+void setUnisonSpread(std::vector<DSP::SynthVoice*> voices, float norm)
+{
+    std::for_each(voices.begin(), voices.end(), [norm] (auto& v) { v->setUnisonSpread(norm); });
+}
+
 void setAttTimeVCA(std::vector<DSP::SynthVoice*> voices, float ms)
 {
     std::for_each(voices.begin(), voices.end(), [ms] (auto& v) { v->setAttTimeVCA(ms); });
@@ -108,6 +123,10 @@ static const std::vector<mrta::ParameterInfo> paramVector
     { Param::ID::OscillatorSinVol, Param::Name::OscillatorSinVol, Param::Units::dB, -12.f, Param::Ranges::VolMin, Param::Ranges::VolMax, Param::Ranges::VolInc, Param::Ranges::VolSkw },
     { Param::ID::OscillatorVol,    Param::Name::OscillatorVol,    Param::Units::dB,   0.f, Param::Ranges::VolMin, Param::Ranges::VolMax, Param::Ranges::VolInc, Param::Ranges::VolSkw },
 
+    { Param::ID::UnisonVoices, Param::Name::UnisonVoices, "",                   1.f, Param::Ranges::UnisonVoicesMin, Param::Ranges::UnisonVoicesMax, Param::Ranges::UnisonVoicesInc, Param::Ranges::UnisonVoicesSkw },
+    { Param::ID::UnisonDetune, Param::Name::UnisonDetune, Param::Units::Cents, 20.f, Param::Ranges::UnisonDetuneMin, Param::Ranges::UnisonDetuneMax, Param::Ranges::UnisonDetuneInc, Param::Ranges::UnisonDetuneSkw },
+    { Param::ID::UnisonSpread, Param::Name::UnisonSpread, "",                 0.5f, Param::Ranges::UnisonSpreadMin, Param::Ranges::UnisonSpreadMax, Param::Ranges::UnisonSpreadInc, Param::Ranges::UnisonSpreadSkw },
+
     { Param::ID::VCA_AttTime,   Param::Name::VCA_AttTime,   Param::Units::Ms,  50.0f, Param::Ranges::EnvTimeMin,    Param::Ranges::EnvTimeMax,    Param::Ranges::EnvTimeInc,    Param::Ranges::EnvTimeSkw },
     { Param::ID::VCA_DecayTime, Param::Name::VCA_DecayTime, Param::Units::Ms,  10.0f, Param::Ranges::EnvTimeMin,    Param::Ranges::EnvTimeMax,    Param::Ranges::EnvTimeInc,    Param::Ranges::EnvTimeSkw },
     { Param::ID::VCA_Sustain,   Param::Name::VCA_Sustain,   "",                 0.7f, Param::Ranges::EnvSustainMin, Param::Ranges::EnvSustainMax, Param::Ranges::EnvSustainInc, Param::Ranges::EnvSustainSkw },
@@ -146,6 +165,9 @@ SynthAudioProcessor::SynthAudioProcessor() :
     paramManager.registerParameterCallback(Param::ID::OscillatorTriVol, [this] (float value, bool force) { setOscTriVol(voices, value, force); });
     paramManager.registerParameterCallback(Param::ID::OscillatorSinVol, [this] (float value, bool force) { setOscSinVol(voices, value, force); });
     paramManager.registerParameterCallback(Param::ID::OscillatorVol, [this] (float value, bool force) { setOscVol(voices, value, force); });
+    paramManager.registerParameterCallback(Param::ID::UnisonVoices, [this] (float value, bool force) { setUnisonVoices(voices, static_cast<unsigned int>(std::round(value))); });
+    paramManager.registerParameterCallback(Param::ID::UnisonDetune, [this] (float value, bool force) { setUnisonDetune(voices, value); });
+    paramManager.registerParameterCallback(Param::ID::UnisonSpread, [this] (float value, bool force) { setUnisonSpread(voices, value); });
     paramManager.registerParameterCallback(Param::ID::VCA_AttTime, [this] (float value, bool force) { setAttTimeVCA(voices, value); });
     paramManager.registerParameterCallback(Param::ID::VCA_DecayTime, [this] (float value, bool force) { setDecayTimeVCA(voices, value); });
     paramManager.registerParameterCallback(Param::ID::VCA_Sustain, [this] (float value, bool force) { setSustainVCA(voices, value); });
@@ -168,10 +190,10 @@ SynthAudioProcessor::~SynthAudioProcessor()
 {
 }
 
-void SynthAudioProcessor::prepareToPlay(double sampleRate, int /*samplesPerBlock*/)
+void SynthAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
+    synth.prepare(sampleRate, samplesPerBlock, getTotalNumOutputChannels());
     paramManager.updateParameters(true);
-    synth.setCurrentPlaybackSampleRate(sampleRate);
 }
 
 void SynthAudioProcessor::releaseResources()
@@ -181,7 +203,11 @@ void SynthAudioProcessor::releaseResources()
 void SynthAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
-    paramManager.updateParameters();
+
+    // The parameters are applied to every voice, they wait in the parameter manager
+    // while a synth worker that missed its deadline still renders one
+    if (!synth.hasLateVoices())
+        paramManager.updateParameters();
 
     buffer.clear();
     synth.renderNextBlock(buffer, midiMessages, 0, buffer.getNumSamples());
@@ -2,6 +2,7 @@
 
 #include <JuceHeader.h>
 #include "Synth.h"
+#include "ParallelSynthesiser.h"
 
 namespace Param
 {
@@ -13,6 +14,10 @@ namespace Param
         static const juce::String OscillatorVol { "oscillator_volume" };
         static const juce::String OutputVol { "output_vol" };
 
+        static const juce::String UnisonVoices { "unison_voices" };
+        static const juce::String UnisonDetune { "unison_detune" };
+        static const juce::String UnisonSpread { "unison_spread" };
+
         static const juce::String VCA_AttTime { "vca_att_time" };
         static const juce::String VCA_DecayTime { "vca_decay_time" };
         static const juce::String VCA_Sustain { "vca_sustain_level" };
@@ -41,6 +46,10 @@ namespace Param
         static const juce::String OscillatorVol { "Osc. Vol." };
         static const juce::String OutputVol { "Output Vol." };
 
+        static const juce::String UnisonVoices { "Unison Voices" };
+        static const juce::String UnisonDetune { "Unison Detune" };
+        static const juce::String UnisonSpread { "Unison Spread" };
+
         static const juce::String VCA_AttTime { "VCA Attack Time" };
         static const juce::String VCA_DecayTime { "VCA Decay Time" };
         static const juce::String VCA_Sustain { "VCA Sustain" };
@@ -69,6 +78,21 @@ namespace Param
         static constexpr float VolInc { 0.1f };
         static constexpr float VolSkw { 2.8f };
 
+        static constexpr float UnisonVoicesMin { 1.f };
+        static constexpr float UnisonVoicesMax { 16.f };
+        static constexpr float UnisonVoicesInc { 1.f };
+        static constexpr float UnisonVoicesSkw { 1.f };
+
+        static constexpr float UnisonDetuneMin { 0.f };
+        static constexpr float UnisonDetuneMax { 100.f };
+        static constexpr float UnisonDetuneInc { 0.1f };
+        static constexpr float UnisonDetuneSkw { 0.5f };
+
+        static constexpr float UnisonSpreadMin { 0.f };
+        static constexpr float UnisonSpreadMax { 1.f };
+        static constexpr float UnisonSpreadInc { 0.001f };
+        static constexpr float UnisonSpreadSkw { 1.f };
+
         static constexpr float EnvTimeMin { 1.f };
         static constexpr float EnvTimeMax { 1000.f };
         static constexpr float EnvTimeInc { 1.f };
@@ -108,6 +132,7 @@ namespace Param
         static const juce::String Hz { "Hz" };
         static const juce::String dB { "dB" };
         static const juce::String Ms { "ms" };
+        static const juce::String Cents { "ct" };
     }
 }
 
@@ -141,12 +166,14 @@ public:
     void changeProgramName(int, const juce::String&) override;
     //==============================================================================
 
-    static constexpr size_t NUM_VOICES { 8 };
+    // All 64 voices with 4 unison copies and the modulated filter take about a third of one core
+    // even when rendered serially, see tests/SynthScalingBenchmark.cpp
+    static constexpr size_t NUM_VOICES { 64 };
 
 private:
     mrta::ParameterManager paramManager;
     std::vector<DSP::SynthVoice*> voices;
-    juce::Synthesiser synth;
+    DSP::ParallelSynthesiser synth;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SynthAudioProcessor)
 };
\ No newline at end of file
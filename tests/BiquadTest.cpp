@@ -0,0 +1,131 @@
+#include "Biquad.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// Checks the vectorised Biquad path against the scalar one for every channel count up to two full groups and one more,
+// both paths run the same operations in the same order, so they may only differ by floating point contraction
+
+namespace
+{
+
+constexpr unsigned int MaxNumChannels { 9 };
+constexpr unsigned int NumSamples { 4096 };
+
+// Relative to the output peak, a few ulps
+constexpr float Tolerance { 1e-6f };
+
+// RBJ cookbook peaking filter, normalised by a0
+std::array<float, DSP::Biquad::CoeffsPerSection> peakingCoeffs(double freq, double q, double gainDb, double sampleRate)
+{
+    const double a { std::pow(10.0, gainDb / 40.0) };
+    const double w { 6.283185307179586 * freq / sampleRate };
+    const double alpha { std::sin(w) / (2.0 * q) };
+    const double a0 { 1.0 + alpha / a };
+
+    return { static_cast<float>((1.0 + alpha * a) / a0), static_cast<float>(-2.0 * std::cos(w) / a0),
+             static_cast<float>((1.0 - alpha * a) / a0), static_cast<float>(-2.0 * std::cos(w) / a0),
+             static_cast<float>((1.0 - alpha / a) / a0) };
+}
+
+// RBJ cookbook lowpass, normalised by a0
+std::array<float, DSP::Biquad::CoeffsPerSection> lowpassCoeffs(double freq, double q, double sampleRate)
+{
+    const double w { 6.283185307179586 * freq / sampleRate };
+    const double alpha { std::sin(w) / (2.0 * q) };
+    const double a0 { 1.0 + alpha };
+
+    return { static_cast<float>(0.5 * (1.0 - std::cos(w)) / a0), static_cast<float>((1.0 - std::cos(w)) / a0),
+             static_cast<float>(0.5 * (1.0 - std::cos(w)) / a0), static_cast<float>(-2.0 * std::cos(w) / a0),
+             static_cast<float>((1.0 - alpha) / a0) };
+}
+
+void setCoeffs(DSP::Biquad& biquad)
+{
+    biquad.setSectionCoeffs(peakingCoeffs(120.0, 0.7, 9.0, 48000.0), 0);
+    biquad.setSectionCoeffs(peakingCoeffs(2500.0, 4.0, -12.0, 48000.0), 1);
+    biquad.setSectionCoeffs(lowpassCoeffs(9000.0, 0.9, 48000.0), 2);
+}
+
+bool testChannels(unsigned int numChannels)
+{
+    // Allocated for more channels than processed, as the EQ does for mono on a stereo bus
+    DSP::Biquad vectorised { 3, MaxNumChannels };
+    DSP::Biquad scalar { 3, MaxNumChannels };
+    setCoeffs(vectorised);
+    setCoeffs(scalar);
+
+    std::mt19937 rng { numChannels };
+    std::uniform_real_distribution<float> noise { -1.f, 1.f };
+
+    std::vector<std::vector<float>> input(numChannels, std::vector<float>(NumSamples));
+    for (auto& channel : input)
+        for (auto& x : channel)
+            x = noise(rng);
+
+    // Block path, with block sizes that do not line up with the chunks
+    std::vector<std::vector<float>> vectorisedOutput(numChannels, std::vector<float>(NumSamples));
+    const unsigned int blockSizes[] { 1, 7, 31, 32, 33, 64, 100, 513 };
+    unsigned int block { 0 };
+    for (unsigned int start = 0; start < NumSamples; ++block)
+    {
+        const unsigned int blockSize { std::min(blockSizes[block % std::size(blockSizes)], NumSamples - start) };
+
+        std::vector<const float*> inputPtrs(numChannels);
+        std::vector<float*> outputPtrs(numChannels);
+        for (unsigned int c = 0; c < numChannels; ++c)
+        {
+            inputPtrs[c] = input[c].data() + start;
+            outputPtrs[c] = vectorisedOutput[c].data() + start;
+        }
+
+        vectorised.process(outputPtrs.data(), inputPtrs.data(), numChannels, blockSize);
+        start += blockSize;
+    }
+
+    // Single sample flavour, scalar for every channel
+    std::vector<std::vector<float>> scalarOutput(numChannels, std::vector<float>(NumSamples));
+    std::vector<float> frameIn(numChannels);
+    std::vector<float> frameOut(numChannels);
+    for (unsigned int n = 0; n < NumSamples; ++n)
+    {
+        for (unsigned int c = 0; c < numChannels; ++c)
+            frameIn[c] = input[c][n];
+
+        scalar.process(frameOut.data(), frameIn.data(), numChannels);
+
+        for (unsigned int c = 0; c < numChannels; ++c)
+            scalarOutput[c][n] = frameOut[c];
+    }
+
+    float error { 0.f };
+    float peak { 0.f };
+    for (unsigned int c = 0; c < numChannels; ++c)
+    {
+        for (unsigned int n = 0; n < NumSamples; ++n)
+        {
+            error = std::fmax(error, std::fabs(vectorisedOutput[c][n] - scalarOutput[c][n]));
+            peak = std::fmax(peak, std::fabs(scalarOutput[c][n]));
+        }
+    }
+
+    const bool passed { error <= Tolerance * peak };
+    std::printf("%-8s %u channels  max error %.3g, tolerance %.3g\n", passed ? "[PASS]" : "[FAIL]", numChannels,
+                static_cast<double>(error), static_cast<double>(Tolerance * peak));
+    return passed;
+}
+
+}
+
+int main()
+{
+    bool passed { true };
+    for (unsigned int numChannels = 1; numChannels <= MaxNumChannels; ++numChannels)
+        passed = testChannels(numChannels) && passed;
+
+    return passed ? 0 : 1;
+}
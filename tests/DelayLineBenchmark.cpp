@@ -0,0 +1,158 @@
+#include "DelayLine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define DELAY_BENCHMARK_HAS_TSC 1
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define DELAY_BENCHMARK_HAS_TSC 1
+#else
+#define DELAY_BENCHMARK_HAS_TSC 0
+#endif
+
+// Runs a stereo chorus through the modulated delay line with every interpolation and prints the cost
+// per sample, and checks that each fits in a fixed share of one core
+// Cycles are time stamp counter ticks, which run at the nominal clock of the CPU
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr unsigned int NumChannels { 2 };
+constexpr unsigned int BlockSize { 64 };
+constexpr unsigned int MaxDelay { 4096 };
+constexpr unsigned int FixedDelay { 960 };
+constexpr double DurationSeconds { 10.0 };
+constexpr int NumRuns { 5 };
+
+// Share of one core a stereo delay line may take, several times the measured sinc cost to leave room for slow machines
+constexpr double MaxCoreShare { 0.01 };
+
+const char* getTypeName(DSP::DelayLine::InterpolationType type)
+{
+    switch (type)
+    {
+    case DSP::DelayLine::Linear: return "Linear";
+    case DSP::DelayLine::Lagrange3: return "Lagrange3";
+    case DSP::DelayLine::Allpass: return "Allpass";
+    case DSP::DelayLine::Sinc: return "Sinc";
+    default: return "Unknown";
+    }
+}
+
+unsigned long long readCycles()
+{
+#if DELAY_BENCHMARK_HAS_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+struct Cost
+{
+    double seconds;
+    double cycles;
+};
+
+// Best of a few runs, the others are mostly scheduler noise
+Cost measure(DSP::DelayLine::InterpolationType type, unsigned int numBlocks, float& checksum)
+{
+    std::vector<float> data(4 * NumChannels * BlockSize, 0.f);
+    float* input[NumChannels];
+    float* modulation[NumChannels];
+    float* output[NumChannels];
+    for (unsigned int ch = 0; ch < NumChannels; ++ch)
+    {
+        input[ch] = data.data() + ch * BlockSize;
+        modulation[ch] = data.data() + (NumChannels + ch) * BlockSize;
+        output[ch] = data.data() + (2 * NumChannels + ch) * BlockSize;
+    }
+
+    Cost best { 1e9, 1e18 };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        DSP::DelayLine delayLine { MaxDelay, NumChannels };
+        delayLine.setInterpolationType(type);
+        delayLine.setDelaySamples(FixedDelay);
+
+        double seconds { 0.0 };
+        unsigned long long cycles { 0 };
+        for (unsigned int b = 0; b < numBlocks; ++b)
+        {
+            // A 0.5 Hz sweep of a few ms, the two sides a quarter period apart
+            for (unsigned int ch = 0; ch < NumChannels; ++ch)
+            {
+                for (unsigned int n = 0; n < BlockSize; ++n)
+                {
+                    const float t { static_cast<float>(b * BlockSize + n) };
+                    input[ch][n] = std::sin(0.031f * t + static_cast<float>(ch));
+                    modulation[ch][n] = 120.f * std::sin(6.545e-5f * t + 1.571f * static_cast<float>(ch));
+                }
+            }
+
+            const auto start { std::chrono::steady_clock::now() };
+            const unsigned long long startCycles { readCycles() };
+            delayLine.process(output, input, modulation, NumChannels, BlockSize);
+            cycles += readCycles() - startCycles;
+            seconds += std::chrono::duration<double> { std::chrono::steady_clock::now() - start }.count();
+
+            checksum += output[0][0] + output[NumChannels - 1][BlockSize - 1];
+        }
+
+        best.seconds = std::min(best.seconds, seconds);
+        best.cycles = std::min(best.cycles, static_cast<double>(cycles));
+    }
+
+    return best;
+}
+
+}
+
+int main()
+{
+    const unsigned int numBlocks { static_cast<unsigned int>(DurationSeconds * SampleRate) / BlockSize };
+    const double numSamples { static_cast<double>(numBlocks * BlockSize * NumChannels) };
+
+    bool passed { true };
+    float checksum { 0.f };
+    for (const auto type : { DSP::DelayLine::Linear, DSP::DelayLine::Lagrange3, DSP::DelayLine::Allpass, DSP::DelayLine::Sinc })
+    {
+        const Cost cost { measure(type, numBlocks, checksum) };
+        const double coreShare { cost.seconds / (static_cast<double>(numBlocks * BlockSize) / SampleRate) };
+
+#if defined(NDEBUG)
+        const bool typePassed { coreShare <= MaxCoreShare };
+        const char* status { typePassed ? "[PASS]" : "[FAIL]" };
+#else
+        const bool typePassed { true };
+        const char* status { "[SKIP]" };
+#endif
+
+        std::printf("%-8s %-10s  %6.2f ns per sample", status, getTypeName(type), 1e9 * cost.seconds / numSamples);
+        if (DELAY_BENCHMARK_HAS_TSC)
+            std::printf(", %6.1f cycles per sample", cost.cycles / numSamples);
+        std::printf(", stereo at %.0f Hz %.2f%% of one core, limit %.2f%%\n", SampleRate, 100.0 * coreShare, 100.0 * MaxCoreShare);
+
+        passed = passed && typePassed;
+    }
+
+#if !defined(NDEBUG)
+    std::printf("[SKIP]   the limit is only enforced in optimised builds\n");
+#endif
+
+    // Keeps the rendering from being optimised away
+    if (!std::isfinite(checksum))
+    {
+        std::printf("[FAIL]   output is not finite\n");
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,290 @@
+#include "DelayLine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Checks the linear interpolation of the modulated processing against the read it replaced,
+// and the multi-tap processing against single reads of the modulated processing
+
+namespace
+{
+
+constexpr unsigned int NumChannels { 2 };
+constexpr unsigned int NumSamples { 4096 };
+constexpr unsigned int BlockSize { 64 };
+constexpr unsigned int MaxDelay { 1024 };
+constexpr float Tolerance { 1e-6f };
+
+// The old read split the delay into the fixed part and the modulation, the new one interpolates
+// their sum, whose fractional part keeps fewer bits for long delays
+constexpr float OldPathTolerance { 1e-4f };
+
+// Per channel signals stored as one vector each, handing out the pointer arrays the delay line takes
+struct Signal
+{
+    explicit Signal(unsigned int numSamples) : data(NumChannels, std::vector<float>(numSamples, 0.f)) { }
+
+    // Pointers to a block starting at sample offset
+    const float* const* at(unsigned int offset)
+    {
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+            blockPointers[ch] = data[ch].data() + offset;
+        return blockPointers;
+    }
+
+    std::vector<std::vector<float>> data;
+    float* blockPointers[NumChannels];
+};
+
+float* const* writable(const float* const* pointers)
+{
+    return const_cast<float* const*>(pointers);
+}
+
+const char* getTypeName(DSP::DelayLine::InterpolationType type)
+{
+    switch (type)
+    {
+    case DSP::DelayLine::Linear: return "Linear";
+    case DSP::DelayLine::Lagrange3: return "Lagrange3";
+    case DSP::DelayLine::Allpass: return "Allpass";
+    case DSP::DelayLine::Sinc: return "Sinc";
+    default: return "Unknown";
+    }
+}
+
+// The modulated processing as it was before the interpolation became selectable,
+// reading before writing with the modulation clamped to the buffer
+class OldLinearDelay
+{
+public:
+    OldLinearDelay(unsigned int size, unsigned int delay) :
+        buffer(NumChannels, std::vector<float>(size, 0.f)), bufferSize { size }, delaySamples { delay } { }
+
+    void process(float* const* audioOutput, const float* const* audioInput, const float* const* modInput, unsigned int numSamples)
+    {
+        const float maxMod { static_cast<float>(bufferSize - 1u) };
+
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+        {
+            unsigned int workingWriteIndex { writeIndex };
+            unsigned int workingReadIndex { wrap(workingWriteIndex + bufferSize - delaySamples) };
+
+            for (unsigned int n = 0; n < numSamples; ++n)
+            {
+                const float m { std::fmin(std::fmax(modInput[ch][n], 0.f), maxMod) };
+                const float mFloor { std::floor(m) };
+                const float mFrac0 { m - mFloor };
+                const float mFrac1 { 1.f - mFrac0 };
+
+                const unsigned int readIndex0 { wrap(workingReadIndex + bufferSize - static_cast<unsigned int>(mFloor)) };
+                const unsigned int readIndex1 { wrap(readIndex0 + bufferSize - 1u) };
+
+                const float x { audioInput[ch][n] };
+                audioOutput[ch][n] = buffer[ch][readIndex0] * mFrac1 + buffer[ch][readIndex1] * mFrac0;
+                buffer[ch][workingWriteIndex] = x;
+
+                workingWriteIndex = wrap(workingWriteIndex + 1u);
+                workingReadIndex = wrap(workingReadIndex + 1u);
+            }
+        }
+
+        writeIndex = (writeIndex + numSamples) % bufferSize;
+    }
+
+private:
+    std::vector<std::vector<float>> buffer;
+    unsigned int bufferSize;
+    unsigned int delaySamples;
+    unsigned int writeIndex { 0 };
+
+    unsigned int wrap(unsigned int index) const { return index >= bufferSize ? index - bufferSize : index; }
+};
+
+// Linear is the default, the block and single sample processing have to sound as before
+// for every fixed delay with a modulation that stays inside the buffer
+bool testLinearMatchesOldPath()
+{
+    bool passed { true };
+    for (const unsigned int delay : { 1u, 7u, 300u, MaxDelay - 40u })
+    {
+        Signal input { NumSamples };
+        Signal modulation { NumSamples };
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+        {
+            for (unsigned int n = 0; n < NumSamples; ++n)
+            {
+                input.data[ch][n] = std::sin(0.05f * static_cast<float>(n) + static_cast<float>(ch)) + 0.3f * std::sin(0.71f * static_cast<float>(n));
+                modulation.data[ch][n] = 15.f + 15.f * std::sin(0.003f * static_cast<float>(n + 100 * ch));
+            }
+        }
+
+        // Same buffer size on both sides, so the wrapped reads line up
+        DSP::DelayLine delayLine { MaxDelay, NumChannels };
+        DSP::DelayLine singleSampleDelayLine { MaxDelay, NumChannels };
+        OldLinearDelay oldDelay { delayLine.getBufferSize(), delay };
+        delayLine.setDelaySamples(delay);
+        singleSampleDelayLine.setDelaySamples(delay);
+
+        Signal output { NumSamples };
+        Signal singleSampleOutput { NumSamples };
+        Signal oldOutput { NumSamples };
+        for (unsigned int n = 0; n < NumSamples; n += BlockSize)
+        {
+            delayLine.process(writable(output.at(n)), input.at(n), modulation.at(n), NumChannels, BlockSize);
+            oldDelay.process(writable(oldOutput.at(n)), input.at(n), modulation.at(n), BlockSize);
+        }
+
+        for (unsigned int n = 0; n < NumSamples; ++n)
+        {
+            float x[NumChannels];
+            float m[NumChannels];
+            float y[NumChannels];
+            for (unsigned int ch = 0; ch < NumChannels; ++ch)
+            {
+                x[ch] = input.data[ch][n];
+                m[ch] = modulation.data[ch][n];
+            }
+
+            singleSampleDelayLine.process(y, x, m, NumChannels);
+            for (unsigned int ch = 0; ch < NumChannels; ++ch)
+                singleSampleOutput.data[ch][n] = y[ch];
+        }
+
+        float blockError { 0.f };
+        float singleSampleError { 0.f };
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+        {
+            for (unsigned int n = 0; n < NumSamples; ++n)
+            {
+                blockError = std::max(blockError, std::fabs(output.data[ch][n] - oldOutput.data[ch][n]));
+                singleSampleError = std::max(singleSampleError, std::fabs(singleSampleOutput.data[ch][n] - oldOutput.data[ch][n]));
+            }
+        }
+
+        const bool delayPassed { blockError <= OldPathTolerance && singleSampleError <= OldPathTolerance };
+        std::printf("%-8s linear against the old path, delay %4u  block error %.3g, single sample error %.3g, tolerance %.3g\n",
+                    delayPassed ? "[PASS]" : "[FAIL]", delay, static_cast<double>(blockError),
+                    static_cast<double>(singleSampleError), static_cast<double>(OldPathTolerance));
+        passed = passed && delayPassed;
+    }
+
+    return passed;
+}
+
+// Two taps with their own outputs, one modulated, and two summed into the main output
+bool testTaps(DSP::DelayLine::InterpolationType type)
+{
+    struct TapInfo
+    {
+        float delaySamples;
+        float gain;
+        bool modulated;
+        bool ownOutput;
+    };
+
+    const TapInfo tapInfos[]
+    {
+        { 10.f, 1.f, false, true },
+        { 37.25f, -0.5f, true, true },
+        { 100.5f, 0.25f, false, false },
+        { 517.75f, 0.7f, true, false }
+    };
+    constexpr unsigned int NumTaps { 4 };
+
+    Signal input { NumSamples };
+    Signal modulation { NumSamples };
+    for (unsigned int ch = 0; ch < NumChannels; ++ch)
+    {
+        for (unsigned int n = 0; n < NumSamples; ++n)
+        {
+            input.data[ch][n] = std::sin(0.05f * static_cast<float>(n) + static_cast<float>(ch)) + 0.3f * std::sin(0.71f * static_cast<float>(n));
+            modulation.data[ch][n] = 3.f * std::sin(0.002f * static_cast<float>(n + 100 * ch));
+        }
+    }
+
+    // Reference: every tap read on its own through the modulated processing, whose fixed delay is 1 sample
+    std::vector<Signal> references;
+    for (const auto& info : tapInfos)
+    {
+        references.emplace_back(NumSamples);
+        Signal delayModulation { NumSamples };
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+            for (unsigned int n = 0; n < NumSamples; ++n)
+                delayModulation.data[ch][n] = info.delaySamples - 1.f + (info.modulated ? modulation.data[ch][n] : 0.f);
+
+        DSP::DelayLine reference { MaxDelay, NumChannels };
+        reference.setInterpolationType(type);
+        reference.setDelaySamples(1);
+        for (unsigned int n = 0; n < NumSamples; n += BlockSize)
+            reference.process(writable(references.back().at(n)), input.at(n), delayModulation.at(n), NumChannels, BlockSize);
+
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+            for (auto& y : references.back().data[ch])
+                y *= info.gain;
+    }
+
+    Signal summed { NumSamples };
+    std::vector<Signal> tapOutputs;
+    for (unsigned int t = 0; t < NumTaps; ++t)
+        tapOutputs.emplace_back(NumSamples);
+
+    DSP::DelayLine delayLine { MaxDelay, NumChannels };
+    delayLine.setInterpolationType(type);
+    for (unsigned int n = 0; n < NumSamples; n += BlockSize)
+    {
+        DSP::DelayLine::Tap taps[NumTaps];
+        for (unsigned int t = 0; t < NumTaps; ++t)
+        {
+            taps[t].delaySamples = tapInfos[t].delaySamples;
+            taps[t].gain = tapInfos[t].gain;
+            taps[t].modInput = tapInfos[t].modulated ? modulation.at(n) : nullptr;
+            taps[t].output = tapInfos[t].ownOutput ? writable(tapOutputs[t].at(n)) : nullptr;
+        }
+
+        delayLine.processTaps(writable(summed.at(n)), input.at(n), taps, NumTaps, NumChannels, BlockSize);
+    }
+
+    float tapError { 0.f };
+    float sumError { 0.f };
+    for (unsigned int ch = 0; ch < NumChannels; ++ch)
+    {
+        for (unsigned int n = 0; n < NumSamples; ++n)
+        {
+            float expectedSum { 0.f };
+            for (unsigned int t = 0; t < NumTaps; ++t)
+            {
+                if (tapInfos[t].ownOutput)
+                    tapError = std::max(tapError, std::fabs(tapOutputs[t].data[ch][n] - references[t].data[ch][n]));
+                else
+                    expectedSum += references[t].data[ch][n];
+            }
+
+            sumError = std::max(sumError, std::fabs(summed.data[ch][n] - expectedSum));
+        }
+    }
+
+    // The first tap is an integer delay, an input sample comes out exactly that many samples later
+    const bool delayExact { tapOutputs[0].data[0][NumSamples - 1] == input.data[0][NumSamples - 1 - 10] };
+
+    const bool passed { tapError <= Tolerance && sumError <= Tolerance && delayExact };
+    std::printf("%-8s taps %-10s  own output error %.3g, summed output error %.3g, tolerance %.3g%s\n",
+                passed ? "[PASS]" : "[FAIL]", getTypeName(type), static_cast<double>(tapError),
+                static_cast<double>(sumError), static_cast<double>(Tolerance), delayExact ? "" : ", integer delay is off");
+    return passed;
+}
+
+}
+
+int main()
+{
+    bool passed { testLinearMatchesOldPath() };
+
+    // Allpass taps fall back to linear, it needs a state per read
+    for (const auto type : { DSP::DelayLine::Linear, DSP::DelayLine::Lagrange3, DSP::DelayLine::Sinc })
+        passed = testTaps(type) && passed;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+#include "Flanger.h"
+#include "Delay.h"
+#include "DelayLine.h"
+#include "ParametricEqualizer.h"
+#include "Ramp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Runs the Flanger and the Delay at 48 kHz stereo through their block processing and through
+// the per sample processing it replaced, prints the cost of both and checks that the block
+// processing sounds the same and is not slower
+// The per sample flavours are kept here as they were, driving the single sample delay line,
+// ramp and filter calls
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr unsigned int NumChannels { 2 };
+constexpr unsigned int HostBlockSizes[] { 64, 512 };
+constexpr double DurationSeconds { 10.0 };
+constexpr int NumRuns { 5 };
+
+constexpr float FlangerMaxTimeMs { 20.f };
+constexpr float DelayMaxTimeMs { 2500.f };
+
+// The per sample processing adds the LFO increment to a float phase every sample, the block processing
+// once per block, so their LFOs drift apart over the run and the outputs are only compared at the start
+// Without modulation, e.g. the delay with no wow, both give the same output to the bit
+constexpr double MatchSeconds { 0.25 };
+constexpr float Tolerance { 1e-3f };
+
+// The block processing has to cost no more than this share of the per sample processing
+constexpr double MaxCostRatio { 1.0 };
+
+class PerSampleFlanger
+{
+public:
+    PerSampleFlanger() :
+        delayLine(static_cast<unsigned int>(std::ceil(FlangerMaxTimeMs * static_cast<float>(0.001 * SampleRate))), NumChannels, true),
+        offsetRamp(0.05f),
+        modDepthRamp(0.05f)
+    {
+        delayLine.setInterpolationType(DSP::DelayLine::Lagrange3);
+    }
+
+    void prepare(float offsetMs, float depthMs, float rateHz)
+    {
+        delayLine.prepare(static_cast<unsigned int>(std::round(FlangerMaxTimeMs * static_cast<float>(0.001 * SampleRate))), NumChannels, true);
+        delayLine.setDelaySamples(static_cast<unsigned int>(std::ceil(0.001 * SampleRate)));
+
+        offsetRamp.prepare(SampleRate, true, std::fmax(offsetMs - 1.f, 0.f) * static_cast<float>(0.001 * SampleRate));
+        modDepthRamp.prepare(SampleRate, true, depthMs * static_cast<float>(0.001 * SampleRate));
+
+        phaseState[0] = 0.f;
+        phaseState[1] = static_cast<float>(M_PI / 2.0);
+        phaseInc = static_cast<float>(2.0 * M_PI / SampleRate) * rateHz;
+    }
+
+    void process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
+    {
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
+            float lfo[2] { 0.5f + 0.5f * std::sin(phaseState[0]), 0.5f + 0.5f * std::sin(phaseState[1]) };
+
+            phaseState[0] = std::fmod(phaseState[0] + phaseInc, static_cast<float>(2 * M_PI));
+            phaseState[1] = std::fmod(phaseState[1] + phaseInc, static_cast<float>(2 * M_PI));
+
+            modDepthRamp.applyGain(lfo, numChannels);
+            offsetRamp.applySum(lfo, numChannels);
+
+            float x[2];
+            float y[2];
+            for (unsigned int ch = 0; ch < numChannels; ++ch)
+                x[ch] = input[ch][n];
+
+            delayLine.process(y, x, lfo, numChannels);
+
+            for (unsigned int ch = 0; ch < numChannels; ++ch)
+                output[ch][n] = y[ch];
+        }
+    }
+
+private:
+    DSP::DelayLine delayLine;
+    DSP::Ramp<float> offsetRamp;
+    DSP::Ramp<float> modDepthRamp;
+
+    float phaseState[2] { 0.f, 0.f };
+    float phaseInc { 0.f };
+};
+
+class PerSampleDelay
+{
+public:
+    PerSampleDelay() :
+        delayLine(static_cast<unsigned int>(std::ceil(DelayMaxTimeMs * static_cast<float>(0.001 * SampleRate))), NumChannels, true),
+        filter(1, 2, DSP::ParametricEqualizer::TransposedDirectForm2),
+        preDistortionRamp(0.02f),
+        postDistortionRamp(0.02f),
+        timeRamp(0.5f),
+        wowRamp(0.02f),
+        feedbackRamp(0.02f)
+    {
+    }
+
+    void prepare(float delayTimeMs, float wow, float feedback, float toneFrequency, float distortion)
+    {
+        delayLine.prepare(static_cast<unsigned int>(std::round(DelayMaxTimeMs * static_cast<float>(0.001 * SampleRate))), NumChannels, true);
+        delayLine.setDelaySamples(1);
+
+        filter.setBandType(0, DSP::ParametricEqualizer::LowPass);
+        filter.setBandResonance(0, static_cast<float>(M_SQRT1_2));
+        filter.setBandFrequency(0, toneFrequency);
+        filter.prepare(SampleRate, NumChannels);
+
+        const auto distortionLin = std::pow(10.f, 0.05f * distortion);
+        preDistortionRamp.prepare(SampleRate, true, distortionLin);
+        postDistortionRamp.prepare(SampleRate, true, 2.f / distortionLin);
+        timeRamp.prepare(SampleRate, true, delayTimeMs * static_cast<float>(SampleRate * 0.001));
+        wowRamp.prepare(SampleRate, true, wow * WowDepthMax * static_cast<float>(SampleRate));
+        feedbackRamp.prepare(SampleRate, true, feedback * 0.98f);
+
+        phaseState[0] = 0.f;
+        phaseState[1] = static_cast<float>(M_PI / 2.0);
+        phaseInc = static_cast<float>(2.0 * M_PI / SampleRate) * WowFreqHz;
+
+        delayLine.clear();
+        filter.clear();
+        feedbackState[0] = 0.f;
+        feedbackState[1] = 0.f;
+    }
+
+    void process(float* const* output, const float* const* input, unsigned int numChannels, unsigned int numSamples)
+    {
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
+            const auto lfoLeft { 0.5f + 0.5f * std::sin(phaseState[0]) };
+            const auto lfoRight { 0.5f + 0.5f * std::sin(phaseState[1]) };
+            float lfo[2] { lfoLeft * lfoLeft, lfoRight * lfoRight };
+
+            phaseState[0] = std::fmod(phaseState[0] + phaseInc, static_cast<float>(2 * M_PI));
+            phaseState[1] = std::fmod(phaseState[1] + phaseInc, static_cast<float>(2 * M_PI));
+
+            wowRamp.applyGain(lfo, numChannels);
+            timeRamp.applySum(lfo, numChannels);
+
+            feedbackRamp.applyGain(feedbackState, numChannels);
+
+            float delayIn[2] { 0.f, 0.f };
+            for (unsigned int ch = 0; ch < numChannels; ++ch)
+                delayIn[ch] = input[ch][n] + feedbackState[ch];
+
+            preDistortionRamp.applyGain(delayIn, numChannels);
+            float delayInDistortion[2];
+            for (unsigned int ch = 0; ch < numChannels; ++ch)
+                delayInDistortion[ch] = std::tanh(delayIn[ch]);
+            postDistortionRamp.applyGain(delayInDistortion, numChannels);
+
+            float delayInDistortionFilter[2] { 0.f, 0.f };
+            filter.process(delayInDistortionFilter, delayInDistortion, numChannels);
+
+            delayLine.process(feedbackState, delayInDistortionFilter, lfo, numChannels);
+
+            for (unsigned int ch = 0; ch < numChannels; ++ch)
+                output[ch][n] = feedbackState[ch];
+        }
+    }
+
+private:
+    DSP::DelayLine delayLine;
+    DSP::ParametricEqualizer filter;
+
+    DSP::Ramp<float> preDistortionRamp;
+    DSP::Ramp<float> postDistortionRamp;
+    DSP::Ramp<float> timeRamp;
+    DSP::Ramp<float> wowRamp;
+    DSP::Ramp<float> feedbackRamp;
+
+    float feedbackState[2] { 0.f, 0.f };
+    float phaseState[2] { 0.f, 0.f };
+    float phaseInc { 0.f };
+
+    static constexpr float WowFreqHz { 2.f };
+    static constexpr float WowDepthMax { 0.002f };
+};
+
+// Settings of the plugin defaults, with a delay time short enough to repeat a few times inside the compared start
+struct FlangerSettings
+{
+    static constexpr float OffsetMs { 2.f };
+    static constexpr float DepthMs { 2.f };
+    static constexpr float RateHz { 0.5f };
+};
+
+struct DelaySettings
+{
+    static constexpr float TimeMs { 80.f };
+    static constexpr float Wow { 0.5f };
+    static constexpr float Feedback { 0.5f };
+    static constexpr float ToneHz { 5000.f };
+    static constexpr float DistortionDb { 3.f };
+};
+
+// Per channel signal of the whole run, with the pointer arrays the effects take
+struct Signal
+{
+    explicit Signal(unsigned int numSamples) : data(NumChannels, std::vector<float>(numSamples, 0.f)) { }
+
+    float* const* at(unsigned int offset)
+    {
+        for (unsigned int ch = 0; ch < NumChannels; ++ch)
+            blockPointers[ch] = data[ch].data() + offset;
+        return blockPointers;
+    }
+
+    std::vector<std::vector<float>> data;
+    float* blockPointers[NumChannels];
+};
+
+// A plucked tone every quarter second, so the delay repeats overlap
+Signal createInput(unsigned int numSamples)
+{
+    Signal input { numSamples };
+    for (unsigned int ch = 0; ch < NumChannels; ++ch)
+    {
+        for (unsigned int n = 0; n < numSamples; ++n)
+        {
+            const float t { static_cast<float>(n % 12000) / static_cast<float>(SampleRate) };
+            const float f { 110.f * static_cast<float>(1 + (n / 12000) % 4) };
+            input.data[ch][n] = 0.5f * std::exp(-8.f * t) * std::sin(static_cast<float>(2.0 * M_PI) * f * t + static_cast<float>(ch));
+        }
+    }
+
+    return input;
+}
+
+// Seconds to render the whole input with a fresh effect, best of a few runs, the others are mostly scheduler noise
+template<typename Create>
+double measure(Signal& output, Signal& input, unsigned int numSamples, unsigned int hostBlockSize, Create create)
+{
+    double bestSeconds { 1e9 };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        const auto effect { create() };
+
+        const auto start { std::chrono::steady_clock::now() };
+        for (unsigned int n = 0; n < numSamples; n += hostBlockSize)
+            effect->process(output.at(n), input.at(n), NumChannels, hostBlockSize);
+        const std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+
+        bestSeconds = std::min(bestSeconds, elapsed.count());
+    }
+
+    return bestSeconds;
+}
+
+float getMaxError(const Signal& a, const Signal& b, size_t numSamples)
+{
+    float maxError { 0.f };
+    for (unsigned int ch = 0; ch < NumChannels; ++ch)
+        for (size_t n = 0; n < numSamples; ++n)
+            maxError = std::max(maxError, std::fabs(a.data[ch][n] - b.data[ch][n]));
+    return maxError;
+}
+
+bool report(const char* name, unsigned int hostBlockSize, double perSampleSeconds, double blockSeconds,
+            const Signal& perSampleOutput, const Signal& blockOutput, unsigned int numSamples)
+{
+    const double nsPerSample { 1e9 / (numSamples * NumChannels) };
+    const float error { getMaxError(perSampleOutput, blockOutput, static_cast<size_t>(MatchSeconds * SampleRate)) };
+    const float runError { getMaxError(perSampleOutput, blockOutput, numSamples) };
+    const bool matches { error <= Tolerance };
+
+#if defined(NDEBUG)
+    const bool passed { matches && blockSeconds <= MaxCostRatio * perSampleSeconds && std::isfinite(runError) };
+    const char* status { passed ? "[PASS]" : "[FAIL]" };
+#else
+    const bool passed { matches && std::isfinite(runError) };
+    const char* status { passed ? "[SKIP]" : "[FAIL]" };
+#endif
+
+    std::printf("%-8s %-7s %3u sample blocks  per sample %6.2f ns, block %6.2f ns per sample, %.2fx faster,"
+                " error %.3g over %.0f ms, tolerance %.3g, %.3g over the run\n",
+                status, name, hostBlockSize, perSampleSeconds * nsPerSample, blockSeconds * nsPerSample,
+                perSampleSeconds / blockSeconds, static_cast<double>(error), 1e3 * MatchSeconds,
+                static_cast<double>(Tolerance), static_cast<double>(runError));
+    return passed;
+}
+
+}
+
+int main()
+{
+    const unsigned int numSamples { static_cast<unsigned int>(DurationSeconds * SampleRate) / 512 * 512 };
+
+    Signal input { createInput(numSamples) };
+    Signal perSampleOutput { numSamples };
+    Signal blockOutput { numSamples };
+
+    auto createPerSampleFlanger = []
+    {
+        auto flanger { std::make_unique<PerSampleFlanger>() };
+        flanger->prepare(FlangerSettings::OffsetMs, FlangerSettings::DepthMs, FlangerSettings::RateHz);
+        return flanger;
+    };
+
+    auto createFlanger = []
+    {
+        auto flanger { std::make_unique<DSP::Flanger>(FlangerMaxTimeMs, NumChannels) };
+        flanger->setOffset(FlangerSettings::OffsetMs);
+        flanger->setDepth(FlangerSettings::DepthMs);
+        flanger->setModulationRate(FlangerSettings::RateHz);
+        flanger->prepare(SampleRate, FlangerMaxTimeMs, NumChannels);
+        return flanger;
+    };
+
+    auto createPerSampleDelay = []
+    {
+        auto delay { std::make_unique<PerSampleDelay>() };
+        delay->prepare(DelaySettings::TimeMs, DelaySettings::Wow, DelaySettings::Feedback, DelaySettings::ToneHz, DelaySettings::DistortionDb);
+        return delay;
+    };
+
+    auto createDelay = []
+    {
+        auto delay { std::make_unique<DSP::Delay>(DelayMaxTimeMs, NumChannels) };
+        delay->setDelayTime(DelaySettings::TimeMs);
+        delay->setWow(DelaySettings::Wow);
+        delay->setFeedback(DelaySettings::Feedback);
+        delay->setToneFrequency(DelaySettings::ToneHz);
+        delay->setDistortion(DelaySettings::DistortionDb);
+        delay->prepare(SampleRate, DelayMaxTimeMs, NumChannels);
+        return delay;
+    };
+
+    bool passed { true };
+    for (const unsigned int hostBlockSize : HostBlockSizes)
+    {
+        const double perSampleFlanger { measure(perSampleOutput, input, numSamples, hostBlockSize, createPerSampleFlanger) };
+        const double blockFlanger { measure(blockOutput, input, numSamples, hostBlockSize, createFlanger) };
+        passed = report("Flanger", hostBlockSize, perSampleFlanger, blockFlanger, perSampleOutput, blockOutput, numSamples) && passed;
+
+        const double perSampleDelay { measure(perSampleOutput, input, numSamples, hostBlockSize, createPerSampleDelay) };
+        const double blockDelay { measure(blockOutput, input, numSamples, hostBlockSize, createDelay) };
+        passed = report("Delay", hostBlockSize, perSampleDelay, blockDelay, perSampleOutput, blockOutput, numSamples) && passed;
+    }
+
+#if !defined(NDEBUG)
+    std::printf("[SKIP]   the block processing is only required to be faster in optimised builds\n");
+#endif
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+#include "Gru.h"
+#include "GruQuantizer.h"
+#include "AmpGruParameters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+// Runs the bundled amp model as the plugin does, stereo with the fast activations, and prints the
+// cost per sample for host block sizes from 32 to 2048 and for one sample per call, which leaves
+// nothing for the chunked input projection to share, then the cost with fp16 and int8 recurrent weights
+// Checks that every block size gives the same output and that everything fits in a fixed share of one core at 48 kHz
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr size_t NumChannels { 2 };
+constexpr size_t InputSize { AmpGruParameters::INPUT_SIZE };
+constexpr size_t OutputSize { AmpGruParameters::OUTPUT_SIZE };
+constexpr size_t BlockSizes[] { 1, 32, 64, 128, 256, 512, 1024, 2048 };
+constexpr size_t NumSamples { 2048 * 48 };
+constexpr size_t WeightTypeBlockSize { 512 };
+constexpr int NumRuns { 9 };
+
+// Share of one core the model may take, several times the measured cost to leave room for slow machines
+constexpr double MaxCoreShare { 0.1 };
+
+template <GruWeightType WEIGHT_TYPE>
+using AmpModelWithWeights = Gru<InputSize, OutputSize, AmpGruParameters::HIDDEN_SIZE, GruActivation::Fast, NumChannels, WEIGHT_TYPE>;
+using AmpModel = AmpModelWithWeights<GruWeightType::Float32>;
+
+// A sine at half scale on the left and an octave up on the right, volume and tone at their defaults
+std::vector<float> createInput()
+{
+    std::vector<float> input(NumSamples * NumChannels * InputSize);
+    for (size_t n = 0; n < NumSamples; ++n)
+    {
+        const double phase { 2.0 * M_PI * 220.0 * static_cast<double>(n) / SampleRate };
+        float* frame { input.data() + n * NumChannels * InputSize };
+        for (size_t ch = 0; ch < NumChannels; ++ch)
+        {
+            frame[ch * InputSize + 0] = static_cast<float>(0.5 * std::sin(static_cast<double>(ch + 1) * phase));
+            frame[ch * InputSize + 1] = 0.5f;
+            frame[ch * InputSize + 2] = 0.5f;
+        }
+    }
+
+    return input;
+}
+
+// Model outputs with the per sample pointer arrays the model takes
+struct Output
+{
+    explicit Output(std::vector<float>& input) :
+        data(NumSamples * NumChannels * OutputSize), inputPtrs(NumSamples), outputPtrs(NumSamples)
+    {
+        for (size_t n = 0; n < NumSamples; ++n)
+        {
+            inputPtrs[n] = input.data() + n * NumChannels * InputSize;
+            outputPtrs[n] = data.data() + n * NumChannels * OutputSize;
+        }
+    }
+
+    std::vector<float> data;
+    std::vector<const float*> inputPtrs;
+    std::vector<float*> outputPtrs;
+};
+
+// Seconds to render the whole input in blocks of the given size
+template <typename Model>
+double render(Model& model, Output& output, size_t blockSize)
+{
+    model.reset_state();
+
+    const auto start { std::chrono::steady_clock::now() };
+    for (size_t n = 0; n < NumSamples; n += blockSize)
+        model.process(output.outputPtrs.data() + n, output.inputPtrs.data() + n, std::min(blockSize, NumSamples - n));
+    const std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+
+    return elapsed.count();
+}
+
+struct WeightTypeCost
+{
+    double ns;
+    double errorLevelDb;
+};
+
+// Best cost per sample with the recurrent weights stored as WEIGHT_TYPE, and the output error relative to fp32
+template <GruWeightType WEIGHT_TYPE>
+WeightTypeCost measureWeightType(const AmpGruParameters& parameters, Output& output, const std::vector<float>& float32Output, float& checksum)
+{
+    auto model { std::make_unique<AmpModelWithWeights<WEIGHT_TYPE>>() };
+    model->load_parameters(parameters.params);
+
+    double bestSeconds { 1e9 };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        bestSeconds = std::min(bestSeconds, render(*model, output, WeightTypeBlockSize));
+        checksum += output.data.front() + output.data.back();
+    }
+
+    double errorEnergy { 0.0 };
+    double outputEnergy { 0.0 };
+    for (size_t i = 0; i < float32Output.size(); ++i)
+    {
+        const double difference { static_cast<double>(output.data[i]) - static_cast<double>(float32Output[i]) };
+        errorEnergy += difference * difference;
+        outputEnergy += static_cast<double>(float32Output[i]) * static_cast<double>(float32Output[i]);
+    }
+
+    return { 1e9 * bestSeconds / static_cast<double>(NumSamples), 10.0 * std::log10(errorEnergy / outputEnergy + 1e-30) };
+}
+
+}
+
+int main()
+{
+    const AmpGruParameters parameters;
+    auto model { std::make_unique<AmpModel>() };
+    model->load_parameters(parameters.params);
+
+    std::vector<float> input { createInput() };
+    Output output { input };
+
+    // Best of a few runs, the others are mostly scheduler noise
+    // The block sizes take turns in every run, so a slow stretch of the machine does not hit only one of them
+    constexpr size_t NumBlockSizes { std::size(BlockSizes) };
+    double bestSeconds[NumBlockSizes];
+    std::fill(bestSeconds, bestSeconds + NumBlockSizes, 1e9);
+
+    // The chunks only move the input projection ahead of the recurrent loop, the output is the same to the bit
+    std::vector<float> singleSampleOutput;
+    bool outputsMatch[NumBlockSizes];
+    std::fill(outputsMatch, outputsMatch + NumBlockSizes, true);
+
+    float checksum { 0.f };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        for (size_t i = 0; i < NumBlockSizes; ++i)
+        {
+            bestSeconds[i] = std::min(bestSeconds[i], render(*model, output, BlockSizes[i]));
+            checksum += output.data.front() + output.data.back();
+
+            if (singleSampleOutput.empty())
+                singleSampleOutput = output.data;
+            outputsMatch[i] = outputsMatch[i] && output.data == singleSampleOutput;
+        }
+    }
+
+    std::printf("Amp model, hidden size %zu, %zu channels, fast activations\n", AmpGruParameters::HIDDEN_SIZE, NumChannels);
+
+    bool passed { true };
+    const double singleSampleNs { 1e9 * bestSeconds[0] / static_cast<double>(NumSamples) };
+    for (size_t i = 0; i < NumBlockSizes; ++i)
+    {
+        const double ns { 1e9 * bestSeconds[i] / static_cast<double>(NumSamples) };
+        const double coreShare { ns * 1e-9 * SampleRate };
+
+#if defined(NDEBUG)
+        const bool blockPassed { outputsMatch[i] && coreShare <= MaxCoreShare };
+        const char* status { blockPassed ? "[PASS]" : "[FAIL]" };
+#else
+        const bool blockPassed { outputsMatch[i] };
+        const char* status { blockPassed ? "[SKIP]" : "[FAIL]" };
+#endif
+
+        std::printf("%-8s %4zu sample blocks  %6.1f ns per sample, %.2fx one sample per call, %.2f%% of one core at %.0f Hz, limit %.2f%%%s\n",
+                    status, BlockSizes[i], ns, singleSampleNs / ns, 100.0 * coreShare, SampleRate, 100.0 * MaxCoreShare,
+                    outputsMatch[i] ? "" : ", output differs from one sample per call");
+        passed = passed && blockPassed;
+    }
+
+    // The same input through the reduced precision weights, against the fp32 output of the largest block size
+    const std::vector<float> float32Output { output.data };
+    const WeightTypeCost float32Cost { measureWeightType<GruWeightType::Float32>(parameters, output, float32Output, checksum) };
+    const WeightTypeCost weightTypeCosts[]
+    {
+        float32Cost,
+        measureWeightType<GruWeightType::Float16>(parameters, output, float32Output, checksum),
+        measureWeightType<GruWeightType::Int8>(parameters, output, float32Output, checksum)
+    };
+    const char* weightTypeNames[] { "fp32", "fp16", "int8" };
+
+    for (size_t i = 0; i < std::size(weightTypeCosts); ++i)
+    {
+        const double coreShare { weightTypeCosts[i].ns * 1e-9 * SampleRate };
+
+#if defined(NDEBUG)
+        const bool typePassed { coreShare <= MaxCoreShare };
+        const char* status { typePassed ? "[PASS]" : "[FAIL]" };
+#else
+        const bool typePassed { true };
+        const char* status { "[SKIP]" };
+#endif
+
+        std::printf("%-8s %s weights, %zu sample blocks  %6.1f ns per sample, %.2fx fp32, error level %.1f dB, %.2f%% of one core, limit %.2f%%\n",
+                    status, weightTypeNames[i], WeightTypeBlockSize, weightTypeCosts[i].ns, float32Cost.ns / weightTypeCosts[i].ns,
+                    weightTypeCosts[i].errorLevelDb, 100.0 * coreShare, 100.0 * MaxCoreShare);
+        passed = passed && typePassed;
+    }
+
+#if !defined(NDEBUG)
+    std::printf("[SKIP]   the limit is only enforced in optimised builds\n");
+#endif
+
+    // Keeps the rendering from being optimised away
+    if (!std::isfinite(checksum))
+    {
+        std::printf("[FAIL]   output is not finite\n");
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
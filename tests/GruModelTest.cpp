@@ -0,0 +1,135 @@
+#include <JuceHeader.h>
+
+#include "GruModel.h"
+#include "AmpGruParameters.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Checks that model files written with every recurrent weight type load back into the model
+// the parameters create directly, and that broken files are rejected
+
+namespace
+{
+
+constexpr size_t NumSamples { 4096 };
+
+const char* getTypeName(GruWeightType type)
+{
+    switch (type)
+    {
+    case GruWeightType::Float32: return "fp32";
+    case GruWeightType::Float16: return "fp16";
+    case GruWeightType::Int8: return "int8";
+    default: return "unknown";
+    }
+}
+
+// A sine at half scale on the left and an octave up on the right, volume and tone at their defaults
+std::vector<float> render(GruModel& model)
+{
+    std::vector<float> input(NumSamples * GruModel::NUM_CHANNELS * GruModel::INPUT_SIZE);
+    std::vector<float> output(NumSamples * GruModel::NUM_CHANNELS * GruModel::OUTPUT_SIZE);
+    std::vector<const float*> inputPtrs(NumSamples);
+    std::vector<float*> outputPtrs(NumSamples);
+    for (size_t n = 0; n < NumSamples; ++n)
+    {
+        float* frame { input.data() + n * GruModel::NUM_CHANNELS * GruModel::INPUT_SIZE };
+        for (size_t ch = 0; ch < GruModel::NUM_CHANNELS; ++ch)
+        {
+            frame[ch * GruModel::INPUT_SIZE + 0] = 0.5f * std::sin(0.03f * static_cast<float>((ch + 1) * n));
+            frame[ch * GruModel::INPUT_SIZE + 1] = 0.5f;
+            frame[ch * GruModel::INPUT_SIZE + 2] = 0.5f;
+        }
+
+        inputPtrs[n] = frame;
+        outputPtrs[n] = output.data() + n * GruModel::NUM_CHANNELS * GruModel::OUTPUT_SIZE;
+    }
+
+    model.process(outputPtrs.data(), inputPtrs.data(), NumSamples);
+    return output;
+}
+
+juce::uint32 readUint32(const juce::MemoryBlock& data, size_t offset)
+{
+    return juce::ByteOrder::littleEndianInt(static_cast<const char*>(data.getData()) + offset);
+}
+
+// Saving and loading has to give the model create makes for the weight type, to the bit
+// fp32 files stay at version 1, so older builds still read them
+bool testSaveLoad(GruWeightType type)
+{
+    const AmpGruParameters parameters;
+    const auto view { GruParameterView::from_parameters(parameters.params) };
+
+    const juce::TemporaryFile temporaryFile { ".mgru" };
+    const juce::File& file { temporaryFile.getFile() };
+    const bool saved { GruModel::save(file, view, AmpGruParameters::HIDDEN_SIZE, type) };
+
+    juce::String error;
+    auto loaded { GruModel::load(file, error) };
+    if (!saved || loaded == nullptr)
+    {
+        std::printf("[FAIL]   %s  %s\n", getTypeName(type), saved ? error.toRawUTF8() : "could not be saved");
+        return false;
+    }
+
+    auto created { GruModel::create(view, AmpGruParameters::HIDDEN_SIZE, type) };
+    const bool outputMatches { render(*loaded) == render(*created) };
+
+    juce::MemoryBlock data;
+    file.loadFileAsData(data);
+    const juce::uint32 expectedVersion { type == GruWeightType::Float32 ? 1u : GruModel::FILE_VERSION };
+    const bool headerMatches { data.getSize() >= GruModel::FILE_HEADER_SIZE && readUint32(data, 4) == expectedVersion
+                               && readUint32(data, 28) == static_cast<juce::uint32>(type) };
+
+    const bool passed { outputMatches && headerMatches && loaded->get_weight_type() == type
+                        && loaded->get_hidden_size() == AmpGruParameters::HIDDEN_SIZE };
+    std::printf("%-8s %s  %zu bytes, loaded as %s%s%s\n", passed ? "[PASS]" : "[FAIL]", getTypeName(type), data.getSize(),
+                getTypeName(loaded->get_weight_type()), outputMatches ? "" : ", output differs from the created model",
+                headerMatches ? "" : ", wrong version or weight type in the header");
+    return passed;
+}
+
+// A file cut short and a version 1 file claiming reduced precision weights
+bool testRejected()
+{
+    const AmpGruParameters parameters;
+    const auto view { GruParameterView::from_parameters(parameters.params) };
+
+    const juce::TemporaryFile temporaryFile { ".mgru" };
+    const juce::File& file { temporaryFile.getFile() };
+    GruModel::save(file, view, AmpGruParameters::HIDDEN_SIZE, GruWeightType::Int8);
+
+    juce::MemoryBlock data;
+    file.loadFileAsData(data);
+
+    juce::String truncatedError;
+    file.replaceWithData(data.getData(), data.getSize() - 1);
+    const bool truncatedRejected { GruModel::load(file, truncatedError) == nullptr };
+
+    juce::String versionError;
+    static_cast<char*>(data.getData())[4] = 1;
+    file.replaceWithData(data.getData(), data.getSize());
+    const bool versionRejected { GruModel::load(file, versionError) == nullptr };
+
+    std::printf("%-8s truncated file  %s\n", truncatedRejected ? "[PASS]" : "[FAIL]",
+                truncatedRejected ? truncatedError.toRawUTF8() : "loaded");
+    std::printf("%-8s int8 weights in a version 1 file  %s\n", versionRejected ? "[PASS]" : "[FAIL]",
+                versionRejected ? versionError.toRawUTF8() : "loaded");
+    return truncatedRejected && versionRejected;
+}
+
+}
+
+int main()
+{
+    bool passed { true };
+    for (const auto type : { GruWeightType::Float32, GruWeightType::Float16, GruWeightType::Int8 })
+        passed = testSaveLoad(type) && passed;
+    passed = testRejected() && passed;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+#include "Gru.h"
+#include "GruQuantizer.h"
+#include "AmpGruParameters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Checks the fast GRU activations against the exact ones, within the tolerances documented in GruActivation,
+// and the reduced precision recurrent weights against fp32, within the error levels documented in GruWeightType
+
+namespace
+{
+
+constexpr float TanhTolerance { 1e-4f };
+constexpr float SigmoidTolerance { 5e-5f };
+
+// The bundled amp model amplifies small differences at high volume, where short error bursts show up,
+// so the peak error is only checked up to half volume and the error level relative to the output everywhere
+// Quiet inputs at full volume are left out, the model itself is unstable there,
+// a 1e-4 change of the input already moves the exact output by 0.2
+constexpr float ModelTolerance { 5e-2f };
+constexpr float ModelToleranceMaxVolume { 0.5f };
+constexpr double ModelErrorLevelDb { -35.0 };
+
+// Output error of the reduced precision weights relative to fp32 on the sweep, the bundled model measures
+// -64 dB with fp16 and -35 dB with int8
+constexpr double Float16ErrorLevelDb { -60.0 };
+constexpr double Int8ErrorLevelDb { -30.0 };
+
+// Rounding to the 11 significant bits of a half
+constexpr float HalfRelativeTolerance { 4.8828125e-4f };
+
+bool check(const char* name, float error, float tolerance)
+{
+    const bool passed { error <= tolerance };
+    std::printf("%-8s %s  max error %.3g, tolerance %.3g\n", passed ? "[PASS]" : "[FAIL]", name,
+                static_cast<double>(error), static_cast<double>(tolerance));
+    return passed;
+}
+
+bool testActivations()
+{
+    // Past the input clamp the approximant is flat, cover it as well
+    const Gru<1, 1, 4, GruActivation::Exact> exact;
+    const Gru<1, 1, 4, GruActivation::Fast> fast;
+
+    float tanhError { 0.f };
+    float sigmoidError { 0.f };
+    for (int i = -200000; i <= 200000; ++i)
+    {
+        const float x { 1e-4f * static_cast<float>(i) };
+        tanhError = std::fmax(tanhError, std::fabs(fast.tanh(x) - exact.tanh(x)));
+        sigmoidError = std::fmax(sigmoidError, std::fabs(fast.sigmoid(x) - exact.sigmoid(x)));
+    }
+
+    const bool tanhPassed { check("tanh", tanhError, TanhTolerance) };
+    const bool sigmoidPassed { check("sigmoid", sigmoidError, SigmoidTolerance) };
+    return tanhPassed && sigmoidPassed;
+}
+
+// Every zero and normal half has to come back from a float unchanged, and the SIMD load has to agree
+// with the scalar conversion the model files use, other floats round to the nearest half
+bool testHalfConversion()
+{
+    int roundTripErrors { 0 };
+    int loadErrors { 0 };
+    for (uint32_t sign = 0; sign <= 0x8000u; sign += 0x8000u)
+    {
+        for (uint32_t magnitude = 0; magnitude <= 0x7bffu; magnitude += 4)
+        {
+            alignas(16) uint16_t halves[4];
+            for (uint32_t i = 0; i < 4; ++i)
+            {
+                // Subnormals are flushed to zero on the way in, they are never stored
+                const uint32_t m { magnitude + i < 0x0400u ? 0u : magnitude + i };
+                halves[i] = static_cast<uint16_t>(sign | m);
+                if (float_to_half(half_to_float(halves[i])) != halves[i])
+                    ++roundTripErrors;
+            }
+
+            alignas(16) float loaded[4];
+            DSP::SIMD::store(loaded, DSP::SIMD::loadHalf(halves));
+            for (uint32_t i = 0; i < 4; ++i)
+                if (loaded[i] != half_to_float(halves[i]))
+                    ++loadErrors;
+        }
+    }
+
+    float relativeError { 0.f };
+    for (int i = -3900; i <= 3900; ++i)
+    {
+        const float x { (1.f + 0.5f * std::sin(static_cast<float>(i))) * std::pow(10.f, static_cast<float>(i) / 1000.f) };
+        relativeError = std::fmax(relativeError, std::fabs(half_to_float(float_to_half(x)) - x) / std::fabs(x));
+    }
+
+    const bool bitsPassed { roundTripErrors == 0 && loadErrors == 0 };
+    std::printf("%-8s half   %d halves changed by a round trip, %d loaded differently by SIMD\n",
+                bitsPassed ? "[PASS]" : "[FAIL]", roundTripErrors, loadErrors);
+
+    return check("half   relative", relativeError, HalfRelativeTolerance) && bitsPassed;
+}
+
+// Every int8 weight has to be within half a step of its row scale of the fp32 one
+bool testInt8Quantization()
+{
+    constexpr size_t hiddenSize { AmpGruParameters::HIDDEN_SIZE };
+    const AmpGruParameters parameters;
+
+    float error { 0.f };
+    for (const float* matrix : { parameters.params.weight_hh_r, parameters.params.weight_hh_z, parameters.params.weight_hh_n })
+    {
+        int8_t quantized[hiddenSize * hiddenSize];
+        float scales[hiddenSize];
+        quantize_int8_rows(matrix, hiddenSize, hiddenSize, quantized, scales);
+
+        for (size_t i = 0; i < hiddenSize; ++i)
+            for (size_t j = 0; j < hiddenSize; ++j)
+                error = std::fmax(error, std::fabs(scales[i] * static_cast<float>(quantized[i * hiddenSize + j]) - matrix[i * hiddenSize + j]) / scales[i]);
+    }
+
+    return check("int8   in steps", error, 0.5f + 1e-5f);
+}
+
+// Two seconds at 48 kHz of a 20 Hz to 20 kHz sine sweep, the right channel an octave up,
+// with the tone moving over its range
+std::vector<float> createSweep(double level, float volume)
+{
+    constexpr double sampleRate { 48000.0 };
+    constexpr size_t numSamples { 96000 };
+    constexpr double twoPi { 6.283185307179586 };
+
+    std::vector<float> input(numSamples * 2 * AmpGruParameters::INPUT_SIZE);
+
+    double phase { 0.0 };
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        const double t { static_cast<double>(n) / static_cast<double>(numSamples) };
+        phase += 20.0 * std::pow(1000.0, t) / sampleRate;
+
+        const float tone { static_cast<float>(0.5 - 0.5 * std::cos(twoPi * 2.5 * t)) };
+
+        float* frame { input.data() + n * 2 * AmpGruParameters::INPUT_SIZE };
+        frame[0] = static_cast<float>(level * std::sin(twoPi * phase));
+        frame[1] = volume;
+        frame[2] = tone;
+        frame[3] = static_cast<float>(level * std::sin(twoPi * 2.0 * phase));
+        frame[4] = volume;
+        frame[5] = tone;
+    }
+
+    return input;
+}
+
+// Runs the model in blocks, as the plugin does, so chunk boundaries are covered
+template <typename Model>
+std::vector<float> runModel(Model& model, const std::vector<float>& input, size_t blockSize)
+{
+    constexpr size_t numChannels { 2 };
+    const size_t numSamples { input.size() / (numChannels * AmpGruParameters::INPUT_SIZE) };
+    std::vector<float> output(numSamples * numChannels);
+
+    std::vector<const float*> inputPtrs(numSamples);
+    std::vector<float*> outputPtrs(numSamples);
+    for (size_t n = 0; n < numSamples; ++n)
+    {
+        inputPtrs[n] = input.data() + n * numChannels * AmpGruParameters::INPUT_SIZE;
+        outputPtrs[n] = output.data() + n * numChannels;
+    }
+
+    for (size_t n = 0; n < numSamples; n += blockSize)
+        model.process(outputPtrs.data() + n, inputPtrs.data() + n, std::min(blockSize, numSamples - n));
+
+    return output;
+}
+
+bool testModel()
+{
+    using ExactModel = Gru<AmpGruParameters::INPUT_SIZE, AmpGruParameters::OUTPUT_SIZE, AmpGruParameters::HIDDEN_SIZE, GruActivation::Exact, 2>;
+    using FastModel = Gru<AmpGruParameters::INPUT_SIZE, AmpGruParameters::OUTPUT_SIZE, AmpGruParameters::HIDDEN_SIZE, GruActivation::Fast, 2>;
+
+    const AmpGruParameters parameters;
+
+    float error { 0.f };
+    double errorLevelDb { -300.0 };
+
+    // The whole volume range and input levels up to full scale
+    for (const double level : { 0.3, 0.5, 1.0 })
+    {
+        for (const float volume : { 0.f, 0.5f, 1.f })
+        {
+            const std::vector<float> input { createSweep(level, volume) };
+
+            auto exact { std::make_unique<ExactModel>() };
+            auto fast { std::make_unique<FastModel>() };
+            exact->load_parameters(parameters.params);
+            fast->load_parameters(parameters.params);
+
+            const std::vector<float> exactOutput { runModel(*exact, input, 512) };
+            const std::vector<float> fastOutput { runModel(*fast, input, 512) };
+
+            double errorEnergy { 0.0 };
+            double outputEnergy { 0.0 };
+            for (size_t i = 0; i < exactOutput.size(); ++i)
+            {
+                const float difference { fastOutput[i] - exactOutput[i] };
+                if (volume <= ModelToleranceMaxVolume)
+                    error = std::fmax(error, std::fabs(difference));
+                errorEnergy += static_cast<double>(difference) * static_cast<double>(difference);
+                outputEnergy += static_cast<double>(exactOutput[i]) * static_cast<double>(exactOutput[i]);
+            }
+
+            errorLevelDb = std::fmax(errorLevelDb, 10.0 * std::log10(errorEnergy / outputEnergy + 1e-30));
+        }
+    }
+
+    const bool errorPassed { check("model", error, ModelTolerance) };
+
+    const bool levelPassed { errorLevelDb <= ModelErrorLevelDb };
+    std::printf("%-8s model  error level %.1f dB, tolerance %.1f dB\n", levelPassed ? "[PASS]" : "[FAIL]",
+                errorLevelDb, ModelErrorLevelDb);
+
+    return errorPassed && levelPassed;
+}
+
+// Output error level of a weight type against fp32, and the same model after its recurrent matrices
+// went through the model file storage, which has to reload to the same weights
+// Quiet inputs at full volume are left out as in testModel, the fp16 rounding alone moves the output 20 dB there
+template <GruWeightType WEIGHT_TYPE>
+bool testWeightType(const char* name, double maxErrorLevelDb)
+{
+    constexpr size_t hiddenSize { AmpGruParameters::HIDDEN_SIZE };
+    using Float32Model = Gru<AmpGruParameters::INPUT_SIZE, AmpGruParameters::OUTPUT_SIZE, hiddenSize, GruActivation::Fast, 2>;
+    using ReducedModel = Gru<AmpGruParameters::INPUT_SIZE, AmpGruParameters::OUTPUT_SIZE, hiddenSize, GruActivation::Fast, 2, WEIGHT_TYPE>;
+
+    const AmpGruParameters parameters;
+
+    auto stored { std::make_unique<GruParameters<AmpGruParameters::INPUT_SIZE, AmpGruParameters::OUTPUT_SIZE, hiddenSize>>(parameters.params) };
+    std::vector<unsigned char> bytes(get_recurrent_matrix_bytes(WEIGHT_TYPE, hiddenSize));
+    for (float* matrix : { stored->weight_hh_r, stored->weight_hh_z, stored->weight_hh_n })
+    {
+        encode_recurrent_matrix(WEIGHT_TYPE, matrix, hiddenSize, bytes.data());
+        decode_recurrent_matrix(WEIGHT_TYPE, bytes.data(), hiddenSize, matrix);
+    }
+
+    double errorLevelDb { -300.0 };
+    bool storedMatches { true };
+    for (const double level : { 0.3, 0.5, 1.0 })
+    {
+        for (const float volume : { 0.f, 0.5f, 1.f })
+        {
+            if (volume > ModelToleranceMaxVolume && level < 1.0)
+                continue;
+
+            const std::vector<float> input { createSweep(level, volume) };
+
+            auto float32 { std::make_unique<Float32Model>() };
+            auto reduced { std::make_unique<ReducedModel>() };
+            auto reloaded { std::make_unique<ReducedModel>() };
+            float32->load_parameters(parameters.params);
+            reduced->load_parameters(parameters.params);
+            reloaded->load_parameters(*stored);
+
+            const std::vector<float> float32Output { runModel(*float32, input, 512) };
+            const std::vector<float> reducedOutput { runModel(*reduced, input, 512) };
+            storedMatches = storedMatches && runModel(*reloaded, input, 512) == reducedOutput;
+
+            double errorEnergy { 0.0 };
+            double outputEnergy { 0.0 };
+            for (size_t i = 0; i < float32Output.size(); ++i)
+            {
+                const double difference { static_cast<double>(reducedOutput[i]) - static_cast<double>(float32Output[i]) };
+                errorEnergy += difference * difference;
+                outputEnergy += static_cast<double>(float32Output[i]) * static_cast<double>(float32Output[i]);
+            }
+
+errorLevelDb = std::fmax(errorLevelDb, 10.0 * std::log10(errorEnergy / outputEnergy + 1e-30));
+        }
+    }
+
+    const bool passed { errorLevelDb <= maxErrorLevelDb && storedMatches };
+    std::printf("%-8s %-6s error level against fp32 %.1f dB, tolerance %.1f dB, %zu bytes per recurrent matrix%s\n",
+                passed ? "[PASS]" : "[FAIL]", name, errorLevelDb, maxErrorLevelDb, bytes.size(),
+                storedMatches ? "" : ", stored weights reload differently");
+    return passed;
+}
+
+}
+
+int main()
+{
+    bool passed { testActivations() };
+    passed = testModel() && passed;
+    passed = testHalfConversion() && passed;
+    passed = testInt8Quantization() && passed;
+    passed = testWeightType<GruWeightType::Float16>("fp16", Float16ErrorLevelDb) && passed;
+    passed = testWeightType<GruWeightType::Int8>("int8", Int8ErrorLevelDb) && passed;
+    return passed ? 0 : 1;
+}
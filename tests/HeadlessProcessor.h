@@ -0,0 +1,30 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+// The smallest processor a parameter manager can be attached to, for headless tests and benchmarks
+// Subclasses own the parameter manager and forward the state to it if they need one
+class HeadlessProcessor : public juce::AudioProcessor
+{
+public:
+    HeadlessProcessor() = default;
+
+    //==============================================================================
+    const juce::String getName() const override { return "Headless"; }
+    void prepareToPlay(double, int) override { }
+    void releaseResources() override { }
+    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override { }
+    double getTailLengthSeconds() const override { return 0.0; }
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override { }
+    const juce::String getProgramName(int) override { return {}; }
+    void changeProgramName(int, const juce::String&) override { }
+    void getStateInformation(juce::MemoryBlock&) override { }
+    void setStateInformation(const void*, int) override { }
+    //==============================================================================
+};
@@ -0,0 +1,84 @@
+#include "Oscillator.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// Runs every oscillator type at frequencies up to and above Nyquist, including the top of the
+// frequency range at low sample rates, the phase has to stay in [0, 1) and the output bounded
+// Build with -fsanitize=address to also catch table reads past the end
+
+namespace
+{
+
+// Band-limited waveforms overshoot a little around their edges, DPW scales up near Nyquist
+constexpr float MaxAmplitude { 4.f };
+
+const char* getTypeName(DSP::Oscillator::OscType type)
+{
+    switch (type)
+    {
+    case DSP::Oscillator::Sin: return "Sin";
+    case DSP::Oscillator::TriAliased: return "TriAliased";
+    case DSP::Oscillator::SawAliased: return "SawAliased";
+    case DSP::Oscillator::TriAA: return "TriAA";
+    case DSP::Oscillator::SawAA: return "SawAA";
+    case DSP::Oscillator::SawWT: return "SawWT";
+    case DSP::Oscillator::TriWT: return "TriWT";
+    case DSP::Oscillator::SqrWT: return "SqrWT";
+    case DSP::Oscillator::SawBLEP: return "SawBLEP";
+    case DSP::Oscillator::SqrBLEP: return "SqrBLEP";
+    case DSP::Oscillator::PulseBLEP: return "PulseBLEP";
+    default: return "Unknown";
+    }
+}
+
+bool testType(DSP::Oscillator::OscType type)
+{
+    float peak { 0.f };
+    bool finite { true };
+
+    DSP::Oscillator osc;
+    osc.setType(type);
+
+    std::vector<float> output(1000);
+    for (const double sampleRate : { 8000.0, 22050.0, 48000.0, 192000.0 })
+    {
+        for (const float frequency : { 0.1f, 440.f, 3999.f, 4000.f, 9000.f, 10000.f, 20000.f })
+        {
+            // Prepared before and after the frequency change, both have to clamp the increment
+            osc.setFrequency(frequency);
+            osc.prepare(sampleRate);
+            osc.process(output.data(), static_cast<unsigned int>(output.size()));
+
+            osc.prepare(sampleRate);
+            osc.setFrequency(frequency);
+            osc.process(output.data(), static_cast<unsigned int>(output.size()));
+
+            for (unsigned int n = 0; n < 100; ++n)
+                output[n] = osc.process();
+
+            for (const float y : output)
+            {
+                finite = finite && std::isfinite(y);
+                peak = std::fmax(peak, std::fabs(y));
+            }
+        }
+    }
+
+    const bool passed { finite && peak <= MaxAmplitude };
+    std::printf("%-8s %-10s  peak %.3g, limit %.3g%s\n", passed ? "[PASS]" : "[FAIL]", getTypeName(type),
+                static_cast<double>(peak), static_cast<double>(MaxAmplitude), finite ? "" : ", not finite");
+    return passed;
+}
+
+}
+
+int main()
+{
+    bool passed { true };
+    for (unsigned int type = DSP::Oscillator::Sin; type <= DSP::Oscillator::PulseBLEP; ++type)
+        passed = testType(static_cast<DSP::Oscillator::OscType>(type)) && passed;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#include <JuceHeader.h>
+
+#include "GruModel.h"
+#include "AmpGruParameters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Runs the amp model headless at 1x, 2x and 4x oversampling, the way AmpModelProcessor does, and prints
+// the share of real time each factor takes on a sine sweep and the aliasing left on a stepped sine sweep
+// Aliasing is the output power away from the harmonics of the tone, relative to the power on them
+// Usage: oversampling_benchmark [inputLevel=0.5] [volume=1] [blockSize=512]
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr size_t NumChannels { GruModel::NUM_CHANNELS };
+constexpr size_t MaxStages { 2 };
+constexpr float Tone { 0.5f };
+
+constexpr double SweepSeconds { 10.0 };
+constexpr int NumRuns { 3 };
+
+constexpr int FftOrder { 14 };
+constexpr int FftSize { 1 << FftOrder };
+constexpr double WarmupSeconds { 0.5 };
+
+// Bins on each side of a harmonic that belong to it, the Blackman-Harris main lobe spans 4
+constexpr int HarmonicHalfWidth { 6 };
+
+// Tones of the stepped sweep, each moved to an odd FFT bin so aliases never land on a harmonic
+constexpr double StepFrequencies[] { 500.0, 1000.0, 2000.0, 3000.0, 5000.0, 7000.0, 10000.0, 14000.0, 18000.0 };
+
+// The model path of AmpModelProcessor with fixed controls, oversampled around the model
+class AmpChain
+{
+public:
+    AmpChain(size_t stages, int blockSize, float volume) :
+        volumeValue { volume * 0.8f }, toneValue { Tone * 0.8f }
+    {
+        if (stages > 0)
+        {
+            oversampler = std::make_unique<juce::dsp::Oversampling<float>>(NumChannels, stages,
+                                                                           juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR,
+                                                                           true, true);
+            oversampler->initProcessing(static_cast<size_t>(blockSize));
+        }
+
+        const int maxModelSamples { blockSize << stages };
+        nnInputBuffer.setSize(maxModelSamples, static_cast<int>(GruModel::INPUT_SIZE * NumChannels));
+        nnOutputBuffer.setSize(maxModelSamples, static_cast<int>(GruModel::OUTPUT_SIZE * NumChannels));
+
+        model = GruModel::create(GruParameterView::from_parameters(gruParameters.params), AmpGruParameters::HIDDEN_SIZE);
+        model->reset_state();
+    }
+
+    int getLatencySamples() const
+    {
+        return oversampler != nullptr ? static_cast<int>(oversampler->getLatencyInSamples()) : 0;
+    }
+
+    void process(juce::AudioBuffer<float>& buffer)
+    {
+        juce::dsp::AudioBlock<float> hostBlock { buffer };
+        juce::dsp::AudioBlock<float> modelBlock { hostBlock };
+        if (oversampler != nullptr)
+            modelBlock = oversampler->processSamplesUp(hostBlock);
+
+        const size_t numModelSamples { modelBlock.getNumSamples() };
+        float * const * nn_input_write_ptr { nnInputBuffer.getArrayOfWritePointers() };
+        for (size_t k = 0; k < numModelSamples; ++k)
+        {
+            for (size_t ch = 0; ch < NumChannels; ++ch)
+            {
+                nn_input_write_ptr[k][ch * GruModel::INPUT_SIZE + 0] = modelBlock.getSample(static_cast<int>(ch), static_cast<int>(k));
+                nn_input_write_ptr[k][ch * GruModel::INPUT_SIZE + 1] = volumeValue;
+                nn_input_write_ptr[k][ch * GruModel::INPUT_SIZE + 2] = toneValue;
+            }
+        }
+
+        model->process(nnOutputBuffer.getArrayOfWritePointers(), nnInputBuffer.getArrayOfReadPointers(), numModelSamples);
+
+        const float * const * nn_output_read_ptr { nnOutputBuffer.getArrayOfReadPointers() };
+        for (size_t ch = 0; ch < NumChannels; ++ch)
+        {
+            float* model_write_ptr { modelBlock.getChannelPointer(ch) };
+            for (size_t k = 0; k < numModelSamples; ++k)
+                model_write_ptr[k] = nn_output_read_ptr[k][ch * GruModel::OUTPUT_SIZE];
+        }
+
+        if (oversampler != nullptr)
+            oversampler->processSamplesDown(hostBlock);
+    }
+
+private:
+    AmpGruParameters gruParameters;
+    std::unique_ptr<GruModel> model;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+    juce::AudioBuffer<float> nnInputBuffer;
+    juce::AudioBuffer<float> nnOutputBuffer;
+    const float volumeValue;
+    const float toneValue;
+};
+
+// Exponential sine sweep over the audio band, returns the share of real time, best of a few runs
+double measureCost(size_t stages, float level, float volume, int blockSize)
+{
+    const int numBlocks { static_cast<int>(SweepSeconds * SampleRate) / blockSize };
+    const double startFrequency { 20.0 };
+    const double sweepRate { std::log(20000.0 / startFrequency) / (numBlocks * blockSize) };
+
+    juce::AudioBuffer<float> buffer { static_cast<int>(NumChannels), blockSize };
+
+    double bestSeconds { 1e9 };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        AmpChain chain { stages, blockSize, volume };
+
+        double phase { 0.0 };
+        double seconds { 0.0 };
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            for (int n = 0; n < blockSize; ++n)
+            {
+                const double frequency { startFrequency * std::exp(sweepRate * (b * blockSize + n)) };
+                phase = std::fmod(phase + juce::MathConstants<double>::twoPi * frequency / SampleRate, juce::MathConstants<double>::twoPi);
+                for (int ch = 0; ch < static_cast<int>(NumChannels); ++ch)
+                    buffer.setSample(ch, n, level * static_cast<float>(std::sin(phase)));
+            }
+
+            const double start { juce::Time::getMillisecondCounterHiRes() };
+            chain.process(buffer);
+            seconds += 0.001 * (juce::Time::getMillisecondCounterHiRes() - start);
+        }
+
+        bestSeconds = std::min(bestSeconds, seconds);
+    }
+
+    return bestSeconds / (numBlocks * blockSize / SampleRate);
+}
+
+int getToneBin(double frequency)
+{
+    return static_cast<int>(std::round(frequency * FftSize / SampleRate)) | 1;
+}
+
+// Power away from the harmonics of a steady tone relative to the power on them, in dB
+double measureAliasing(size_t stages, int toneBin, float level, float volume, int blockSize)
+{
+    AmpChain chain { stages, blockSize, volume };
+    juce::AudioBuffer<float> buffer { static_cast<int>(NumChannels), blockSize };
+
+    // The FFT works in place on twice its size
+    std::vector<float> capture(2 * FftSize, 0.f);
+
+    // Settles the model state and the filters before the capture
+    const double phaseIncrement { juce::MathConstants<double>::twoPi * toneBin / FftSize };
+    double phase { 0.0 };
+    for (int written { -static_cast<int>(WarmupSeconds * SampleRate) }; written < FftSize; written += blockSize)
+    {
+        for (int n = 0; n < blockSize; ++n)
+        {
+            for (int ch = 0; ch < static_cast<int>(NumChannels); ++ch)
+                buffer.setSample(ch, n, level * static_cast<float>(std::sin(phase)));
+            phase = std::fmod(phase + phaseIncrement, juce::MathConstants<double>::twoPi);
+        }
+
+        chain.process(buffer);
+
+        for (int n = 0; n < blockSize; ++n)
+            if (written + n >= 0 && written + n < FftSize)
+                capture[static_cast<size_t>(written + n)] = buffer.getSample(0, n);
+    }
+
+    juce::dsp::WindowingFunction<float> window { static_cast<size_t>(FftSize), juce::dsp::WindowingFunction<float>::blackmanHarris, false };
+    window.multiplyWithWindowingTable(capture.data(), static_cast<size_t>(FftSize));
+
+    juce::dsp::FFT fft { FftOrder };
+    fft.performFrequencyOnlyForwardTransform(capture.data(), true);
+
+    // DC and the bins next to it are left out, the model output has an offset
+    double harmonicPower { 0.0 };
+    double otherPower { 0.0 };
+    for (int bin = HarmonicHalfWidth + 1; bin <= FftSize / 2; ++bin)
+    {
+        const int harmonic { (bin + toneBin / 2) / toneBin };
+        const double power { static_cast<double>(capture[static_cast<size_t>(bin)]) * capture[static_cast<size_t>(bin)] };
+        if (harmonic >= 1 && std::abs(bin - harmonic * toneBin) <= HarmonicHalfWidth)
+            harmonicPower += power;
+        else
+            otherPower += power;
+    }
+
+    return 10.0 * std::log10((otherPower + 1e-30) / (harmonicPower + 1e-30));
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const float level { argc > 1 ? static_cast<float>(std::atof(argv[1])) : 0.5f };
+    const float volume { argc > 2 ? static_cast<float>(std::atof(argv[2])) : 1.f };
+    const int blockSize { argc > 3 ? std::atoi(argv[3]) : 512 };
+
+    std::printf("Input level %.2f, volume %.2f, tone %.2f, %d sample blocks at %.0f Hz\n\n",
+                static_cast<double>(level), static_cast<double>(volume), static_cast<double>(Tone), blockSize, SampleRate);
+
+    double serialCost { 0.0 };
+    for (size_t stages = 0; stages <= MaxStages; ++stages)
+    {
+        const double cost { measureCost(stages, level, volume, blockSize) };
+        if (stages == 0)
+            serialCost = cost;
+
+        const AmpChain chain { stages, blockSize, volume };
+        std::printf("%zux: %6.2f%% of real time, %.2fx the cost of 1x, latency %d samples\n",
+                    size_t { 1 } << stages, 100.0 * cost, cost / serialCost, chain.getLatencySamples());
+    }
+
+    std::printf("\nAliasing relative to the harmonics, dB\n%8s %8s %8s %8s\n", "Tone Hz", "1x", "2x", "4x");
+
+    double worst[MaxStages + 1] { -1e9, -1e9, -1e9 };
+    for (const double frequency : StepFrequencies)
+    {
+        const int toneBin { getToneBin(frequency) };
+        std::printf("%8.0f", toneBin * SampleRate / FftSize);
+
+        for (size_t stages = 0; stages <= MaxStages; ++stages)
+        {
+            const double aliasing { measureAliasing(stages, toneBin, level, volume, blockSize) };
+            worst[stages] = std::max(worst[stages], aliasing);
+            std::printf(" %8.1f", aliasing);
+        }
+
+        std::printf("\n");
+    }
+
+    std::printf("%8s %8.1f %8.1f %8.1f\n", "worst", worst[0], worst[1], worst[2]);
+    std::printf("\nWorst case suppression against 1x: 2x %.1f dB, 4x %.1f dB\n", worst[0] - worst[1], worst[0] - worst[2]);
+
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include <JuceHeader.h>
+
+#include "HeadlessProcessor.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// Measures the ParameterManager paths processors run on every block, headless
+// Timed changes: the cost of each change scheduled with addTimedParameterChange,
+// the block is rendered through processSubBlocks and split at every change
+// State load: saving and restoring a large session of instances with the binary snapshot
+// and with the ValueTree format that apvts.replaceState restores
+// Usage: parameter_manager_benchmark [blockSize=512] [numInstances=500]
+
+namespace
+{
+
+constexpr int NumParameters { 32 };
+constexpr int NumChannels { 2 };
+constexpr int NumBlocks { 20000 };
+constexpr int NumRuns { 5 };
+constexpr int EventsPerBlock[] { 1, 4, 16, 64, 128 };
+constexpr int NumStateParameters { 64 };
+constexpr int NumStateRuns { 5 };
+
+std::vector<mrta::ParameterInfo> createParameterInfos(int numParameters)
+{
+    std::vector<mrta::ParameterInfo> infos;
+    infos.reserve(static_cast<size_t>(numParameters));
+    for (int i = 0; i < numParameters; ++i)
+        infos.emplace_back("param_" + juce::String { i }, "Param " + juce::String { i }, "", 0.5f, 0.f, 1.f, 1e-4f, 1.f);
+    return infos;
+}
+
+// Every callback stores its value, parameter 0 is the coefficient of a one pole lowpass on the block
+class BenchmarkProcessor : public HeadlessProcessor
+{
+public:
+    explicit BenchmarkProcessor(int numParameters) :
+        paramManager(*this, "Benchmark", createParameterInfos(numParameters)),
+        values(static_cast<size_t>(numParameters), 0.5f)
+    {
+        for (int i = 0; i < numParameters; ++i)
+            paramManager.registerParameterCallback("param_" + juce::String { i },
+            [this, i] (float value, bool /*forced*/)
+            {
+                values[static_cast<size_t>(i)] = value;
+            });
+    }
+
+    void processSubBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        const float coefficient { 0.01f + 0.98f * values[0] };
+        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+        {
+            float* data { buffer.getWritePointer(ch, startSample) };
+            float& state { lowpassStates[static_cast<size_t>(ch)] };
+            for (int n = 0; n < numSamples; ++n)
+            {
+                state += coefficient * (data[n] - state);
+                data[n] = state;
+            }
+        }
+    }
+
+    float getChecksum() const { return lowpassStates[0] + lowpassStates[1]; }
+
+    mrta::ParameterManager paramManager;
+
+    void getStateInformation(juce::MemoryBlock& destData) override { paramManager.getStateInformation(destData); }
+    void setStateInformation(const void* data, int sizeInBytes) override { paramManager.setStateInformation(data, sizeInBytes); }
+
+private:
+    std::vector<float> values;
+    std::array<float, NumChannels> lowpassStates {};
+};
+
+double ticksToNanoseconds(juce::int64 ticks)
+{
+    return 1e9 * juce::Time::highResolutionTicksToSeconds(ticks);
+}
+
+// Nanoseconds per block, best of a few runs, numEvents < 0 is the plain block with updateParameters only
+double measureTimedChanges(BenchmarkProcessor& processor, juce::AudioBuffer<float>& buffer, int numEvents)
+{
+    const int blockSize { buffer.getNumSamples() };
+    juce::int64 bestTicks { std::numeric_limits<juce::int64>::max() };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        const juce::int64 start { juce::Time::getHighResolutionTicks() };
+        for (int b = 0; b < NumBlocks; ++b)
+        {
+            if (numEvents < 0)
+            {
+                processor.paramManager.updateParameters();
+                processor.processSubBlock(buffer, 0, blockSize);
+                continue;
+            }
+
+            // Spread over the block, as a controller sweep would be
+            for (int e = 0; e < numEvents; ++e)
+                processor.paramManager.addTimedParameterChange(e % NumParameters, static_cast<float>((b + e) % 100) * 0.01f,
+                                                              e * blockSize / numEvents);
+
+            processor.paramManager.processSubBlocks(blockSize, blockSize,
+            [&processor, &buffer] (int startSample, int numSamples)
+            {
+                processor.processSubBlock(buffer, startSample, numSamples);
+            });
+        }
+
+        bestTicks = std::min(bestTicks, juce::Time::getHighResolutionTicks() - start);
+    }
+
+    return ticksToNanoseconds(bestTicks) / NumBlocks;
+}
+
+void benchmarkTimedChanges(int blockSize)
+{
+    BenchmarkProcessor processor { NumParameters };
+    juce::AudioBuffer<float> buffer { NumChannels, blockSize };
+    for (int ch = 0; ch < NumChannels; ++ch)
+        for (int n = 0; n < blockSize; ++n)
+            buffer.setSample(ch, n, std::sin(0.1f * static_cast<float>(n + ch)));
+
+    std::printf("Timed changes, %d parameters, %d sample blocks\n", NumParameters, blockSize);
+
+    const double plain { measureTimedChanges(processor, buffer, -1) };
+    const double noEvents { measureTimedChanges(processor, buffer, 0) };
+    std::printf("  updateParameters and the block: %8.0f ns per block\n", plain);
+    std::printf("  processSubBlocks, no changes:   %8.0f ns per block, %+.0f ns\n", noEvents, noEvents - plain);
+
+    for (const int numEvents : EventsPerBlock)
+    {
+        if (numEvents > blockSize)
+            continue;
+
+        const double withEvents { measureTimedChanges(processor, buffer, numEvents) };
+        std::printf("  %3d changes per block:          %8.0f ns per block, %6.1f ns per change\n",
+                    numEvents, withEvents, (withEvents - noEvents) / numEvents);
+    }
+
+    // Keeps the rendering from being optimised away
+    if (!std::isfinite(processor.getChecksum()))
+        std::printf("  output is not finite\n");
+}
+
+// The ValueTree format of the parameters, written before the binary snapshot and still read
+void getValueTreeState(BenchmarkProcessor& processor, juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream stream { destData, false };
+    processor.paramManager.getAPVTS().copyState().writeToStream(stream);
+}
+
+std::vector<float> getRawValues(BenchmarkProcessor& processor)
+{
+    std::vector<float> values;
+    for (const auto& info : processor.paramManager.getParameters())
+        values.push_back(processor.paramManager.getAPVTS().getRawParameterValue(info.ID)->load());
+    return values;
+}
+
+// Two sessions, every instance with its own values in each, so every load changes all parameters
+struct Session
+{
+    std::vector<juce::MemoryBlock> binaryStates;
+    std::vector<juce::MemoryBlock> valueTreeStates;
+    std::vector<std::vector<float>> values;
+};
+
+// Both formats go through the normalised range, which can round the last bit
+bool valuesMatch(const std::vector<float>& a, const std::vector<float>& b)
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [] (float x, float y) { return std::fabs(x - y) <= 1e-6f; });
+}
+
+Session createSession(std::vector<std::unique_ptr<BenchmarkProcessor>>& instances, size_t seed)
+{
+    Session session;
+    for (size_t i = 0; i < instances.size(); ++i)
+    {
+        auto& processor { *instances[i] };
+        for (auto* parameter : processor.getParameters())
+            parameter->setValueNotifyingHost(static_cast<float>((seed + 7 * i + 13 * static_cast<size_t>(parameter->getParameterIndex())) % 97) / 96.f);
+
+        session.binaryStates.emplace_back();
+        processor.getStateInformation(session.binaryStates.back());
+        session.valueTreeStates.emplace_back();
+        getValueTreeState(processor, session.valueTreeStates.back());
+        session.values.push_back(getRawValues(processor));
+        processor.paramManager.updateParameters();
+    }
+
+    return session;
+}
+
+// Milliseconds to restore the whole session, best of a few runs, alternating with the other session
+double measureStateLoad(std::vector<std::unique_ptr<BenchmarkProcessor>>& instances, const Session& session,
+                        const Session& otherSession, bool binary, bool& restoredValuesMatch)
+{
+    juce::int64 bestTicks { std::numeric_limits<juce::int64>::max() };
+    for (int run = 0; run < NumStateRuns; ++run)
+    {
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            const auto& otherState { otherSession.binaryStates[i] };
+            instances[i]->setStateInformation(otherState.getData(), static_cast<int>(otherState.getSize()));
+            instances[i]->paramManager.updateParameters();
+        }
+
+        const juce::int64 start { juce::Time::getHighResolutionTicks() };
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            const auto& state { binary ? session.binaryStates[i] : session.valueTreeStates[i] };
+            instances[i]->setStateInformation(state.getData(), static_cast<int>(state.getSize()));
+        }
+        bestTicks = std::min(bestTicks, juce::Time::getHighResolutionTicks() - start);
+
+        for (size_t i = 0; i < instances.size(); ++i)
+        {
+            restoredValuesMatch = restoredValuesMatch && valuesMatch(getRawValues(*instances[i]), session.values[i]);
+            instances[i]->paramManager.updateParameters();
+        }
+    }
+
+    return 1e-6 * ticksToNanoseconds(bestTicks);
+}
+
+// Milliseconds to save the whole session, best of a few runs
+double measureStateSave(std::vector<std::unique_ptr<BenchmarkProcessor>>& instances, bool binary, size_t& stateSize)
+{
+    juce::int64 bestTicks { std::numeric_limits<juce::int64>::max() };
+    for (int run = 0; run < NumStateRuns; ++run)
+    {
+        stateSize = 0;
+        const juce::int64 start { juce::Time::getHighResolutionTicks() };
+        for (auto& processor : instances)
+        {
+            juce::MemoryBlock state;
+            if (binary)
+                processor->getStateInformation(state);
+            else
+                getValueTreeState(*processor, state);
+            stateSize += state.getSize();
+        }
+        bestTicks = std::min(bestTicks, juce::Time::getHighResolutionTicks() - start);
+    }
+
+    return 1e-6 * ticksToNanoseconds(bestTicks);
+}
+
+void benchmarkStateLoad(int numInstances)
+{
+    std::vector<std::unique_ptr<BenchmarkProcessor>> instances;
+    for (int i = 0; i < numInstances; ++i)
+        instances.push_back(std::make_unique<BenchmarkProcessor>(NumStateParameters));
+
+    const Session firstSession { createSession(instances, 0) };
+    const Session secondSession { createSession(instances, 50) };
+
+    std::printf("\nState of a session with %d instances of %d parameters\n", numInstances, NumStateParameters);
+
+    double loadMs[2] {};
+    for (const bool binary : { false, true })
+    {
+        bool restoredValuesMatch { true };
+        size_t stateSize { 0 };
+        const double saveMs { measureStateSave(instances, binary, stateSize) };
+        loadMs[binary] = measureStateLoad(instances, firstSession, secondSession, binary, restoredValuesMatch);
+
+        std::printf("  %-16s %8zu bytes in all, save %8.2f ms, load %8.2f ms, %7.1f us per instance%s\n",
+                    binary ? "binary snapshot" : "ValueTree", stateSize, saveMs, loadMs[binary],
+                    1e3 * loadMs[binary] / numInstances, restoredValuesMatch ? "" : ", restored values differ");
+    }
+
+    std::printf("  binary snapshot loads %.1fx faster\n", loadMs[false] / loadMs[true]);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const int blockSize { argc > 1 ? std::max(std::atoi(argv[1]), 1) : 512 };
+    const int numInstances { argc > 2 ? std::max(std::atoi(argv[2]), 1) : 500 };
+
+    // The parameter tree runs a timer, it needs the message manager
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    benchmarkTimedChanges(blockSize);
+    benchmarkStateLoad(numInstances);
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <JuceHeader.h>
+
+#include "HeadlessProcessor.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+// Checks the ParameterManager services processors rely on every block, headless
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr int BlockSize { 512 };
+constexpr int NumBlocks { 6 };
+constexpr float Tolerance { 1e-5f };
+
+// Ramps that end inside the first block, inside the second and right away
+struct SmoothedInfo
+{
+    const char* ID;
+    float rampTimeSec;
+};
+
+constexpr SmoothedInfo SmoothedInfos[]
+{
+    { "short_ramp", 0.01f },
+    { "long_ramp", 0.015f },
+    { "no_ramp", 0.f }
+};
+
+std::vector<mrta::ParameterInfo> createSmoothedInfos()
+{
+    std::vector<mrta::ParameterInfo> infos;
+    for (const auto& info : SmoothedInfos)
+        infos.emplace_back(info.ID, info.ID, "", 0.f, 0.f, 1.f, 1e-4f, 1.f);
+    return infos;
+}
+
+class SmoothingProcessor : public HeadlessProcessor
+{
+public:
+    SmoothingProcessor() :
+        paramManager(*this, "Test", createSmoothedInfos())
+    {
+        for (const auto& info : SmoothedInfos)
+            handles.push_back(paramManager.enableSmoothing(info.ID, info.rampTimeSec));
+    }
+
+    mrta::ParameterManager paramManager;
+    std::vector<int> handles;
+};
+
+// Every block after a change has to follow the ramp and then hold the target,
+// including the blocks after the one the ramp ends in
+bool testSmoothing()
+{
+    bool passed { true };
+    for (size_t s = 0; s < std::size(SmoothedInfos); ++s)
+    {
+        const int rampSamples { static_cast<int>(std::round(SmoothedInfos[s].rampTimeSec * SampleRate)) };
+        float maxError { 0.f };
+        int firstBadSample { -1 };
+
+        // One parameter moves from 0 to 1 after a settled block
+        SmoothingProcessor processor;
+        processor.paramManager.prepareSmoothing(SampleRate, BlockSize);
+        processor.paramManager.processSmoothing(BlockSize);
+        processor.getParameters()[static_cast<int>(s)]->setValueNotifyingHost(1.f);
+
+        for (int b = 0; b < NumBlocks; ++b)
+        {
+            processor.paramManager.processSmoothing(BlockSize);
+            const float* values { processor.paramManager.getSmoothedBuffer(processor.handles[s]) };
+            for (int n = 0; n < BlockSize; ++n)
+            {
+                const int k { b * BlockSize + n + 1 };
+                const float expected { k < rampSamples ? static_cast<float>(k) / static_cast<float>(rampSamples) : 1.f };
+                const float error { std::fabs(values[n] - expected) };
+                if (error > maxError)
+                    maxError = error;
+                if (error > Tolerance && firstBadSample < 0)
+                    firstBadSample = b * BlockSize + n;
+            }
+        }
+
+        const bool rampPassed { maxError <= Tolerance };
+        std::printf("%-8s smoothing %-10s  %d sample ramp over %d blocks, max error %.3g, tolerance %.3g",
+                    rampPassed ? "[PASS]" : "[FAIL]", SmoothedInfos[s].ID, rampSamples, NumBlocks,
+                    static_cast<double>(maxError), static_cast<double>(Tolerance));
+        if (firstBadSample >= 0)
+            std::printf(", first wrong at sample %d", firstBadSample);
+        std::printf("\n");
+
+        passed = passed && rampPassed;
+    }
+
+    return passed;
+}
+
+// Every callback logs the sample position of the next sub-block, so the position a change takes effect at
+class SubBlockProcessor : public HeadlessProcessor
+{
+public:
+    struct Change
+    {
+        int index;
+        float value;
+        int sampleOffset;
+    };
+
+    SubBlockProcessor() :
+        paramManager(*this, "Test", { { "host", "Host", "", 0.f, 0.f, 1.f, 1e-4f, 1.f },
+                                      { "timed", "Timed", "", 0.f, 0.f, 1.f, 1e-4f, 1.f } })
+    {
+        for (int i = 0; i < 2; ++i)
+            paramManager.registerParameterCallback(paramManager.getParameters()[static_cast<size_t>(i)].ID,
+            [this, i] (float value, bool forced)
+            {
+                if (!forced)
+                    changes.push_back({ i, value, nextSample });
+            });
+
+        changes.reserve(16);
+    }
+
+    mrta::ParameterManager paramManager;
+    std::vector<Change> changes;
+    int nextSample { 0 };
+};
+
+// Host changes arriving during a sub-block are delivered before the next one,
+// timed changes split the block at their offset
+bool testSubBlocks()
+{
+    constexpr int NumSamples { 1024 };
+    constexpr int MaxSubBlockSize { 256 };
+    constexpr int TimedOffset { 600 };
+
+    SubBlockProcessor processor;
+    processor.paramManager.updateParameters(true);
+    processor.paramManager.addTimedParameterChange(1, 0.7f, TimedOffset);
+
+    std::vector<std::pair<int, int>> subBlocks;
+    processor.paramManager.processSubBlocks(NumSamples, MaxSubBlockSize,
+    [&processor, &subBlocks] (int startSample, int numSamples)
+    {
+        // A host change, e.g. automation from another thread, while the first sub-block renders
+        if (startSample == 0)
+            processor.getParameters()[0]->setValueNotifyingHost(0.5f);
+
+        subBlocks.emplace_back(startSample, numSamples);
+        processor.nextSample = startSample + numSamples;
+    });
+
+    const std::vector<std::pair<int, int>> expectedSubBlocks { { 0, 256 }, { 256, 256 }, { 512, 88 }, { 600, 256 }, { 856, 168 } };
+    const bool subBlocksPassed { subBlocks == expectedSubBlocks };
+    std::printf("%-8s sub-blocks split at the timed change and at %d samples\n", subBlocksPassed ? "[PASS]" : "[FAIL]", MaxSubBlockSize);
+
+    const auto& changes { processor.changes };
+    const bool changesPassed { changes.size() == 2
+                               && changes[0].index == 0 && std::fabs(changes[0].value - 0.5f) <= Tolerance && changes[0].sampleOffset == MaxSubBlockSize
+                               && changes[1].index == 1 && std::fabs(changes[1].value - 0.7f) <= Tolerance && changes[1].sampleOffset == TimedOffset };
+    std::printf("%-8s host change delivered at sample %d, timed change at sample %d\n", changesPassed ? "[PASS]" : "[FAIL]",
+                changes.size() > 0 ? changes[0].sampleOffset : -1, changes.size() > 1 ? changes[1].sampleOffset : -1);
+
+    return subBlocksPassed && changesPassed;
+}
+
+}
+
+int main()
+{
+    // The parameter tree runs a timer, it needs the message manager
+    const juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    bool passed { true };
+    passed = testSmoothing() && passed;
+    passed = testSubBlocks() && passed;
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,118 @@
+#include <JuceHeader.h>
+
+#include "ParallelSynthesiser.h"
+#include "Synth.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// Renders the synth voices headless on 1 to N cores, the audio thread plus 0 to N - 1 workers,
+// and prints the share of real time each configuration takes, run it on an otherwise idle machine
+// Usage: synth_scaling_benchmark [numVoices=64] [blockSize=512] [unisonVoices=4]
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr double DurationSeconds { 10.0 };
+
+// Every voice runs the full path, unison saw bank, modulated filter and envelopes
+void configureVoice(DSP::SynthVoice& voice, unsigned int unisonVoices)
+{
+    voice.setOscSawVol(-12.f, true);
+    voice.setOscTriVol(-12.f, true);
+    voice.setOscSinVol(-12.f, true);
+    voice.setOscVol(0.f, true);
+    voice.setUnisonVoices(unisonVoices);
+    voice.setUnisonDetune(20.f);
+    voice.setUnisonSpread(0.5f);
+
+    voice.setAttTimeVCA(50.f);
+    voice.setDecayTimeVCA(10.f);
+    voice.setSustainVCA(0.7f);
+    voice.setRelTimeVCA(100.f);
+    voice.setAttTimeVCF(10.f);
+    voice.setDecayTimeVCF(100.f);
+    voice.setSustainVCF(0.9f);
+    voice.setRelTimeVCF(100.f);
+
+    voice.setLFOFreqVCF(3.f);
+    voice.setLFOTypeVCF(DSP::SynthVoice::SIN);
+    voice.setEnvAmountVCF(0.3f, true);
+    voice.setLFOAmountVCF(-0.2f, true);
+    voice.setFilterCutoff(2000.f, true);
+    voice.setFilterReso(0.71f, true);
+    voice.setFilterType(DSP::SynthVoice::LPF, true);
+
+    voice.setOutputVol(-12.f, true);
+}
+
+// One chord on all voices every second, held for three quarters of it, returns the share of real time
+double run(int numWorkers, int numVoices, int blockSize, unsigned int unisonVoices)
+{
+    DSP::ParallelSynthesiser synth { numWorkers };
+    synth.addSound(new DSP::SynthSound());
+    for (int i = 0; i < numVoices; ++i)
+    {
+        auto* voice { new DSP::SynthVoice() };
+        configureVoice(*voice, unisonVoices);
+        synth.addVoice(voice);
+    }
+    synth.setNoteStealingEnabled(false);
+    synth.prepare(SampleRate, blockSize, 2);
+
+    juce::AudioBuffer<float> buffer { 2, blockSize };
+    juce::MidiBuffer midi;
+
+    const int numBlocks { static_cast<int>(DurationSeconds * SampleRate) / blockSize };
+    const int blocksPerChord { static_cast<int>(SampleRate) / blockSize };
+
+    double seconds { 0.0 };
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        // 7 is coprime with 96, so the notes of a chord are all different
+        midi.clear();
+        const int chord { b / blocksPerChord };
+        if (b % blocksPerChord == 0 || b % blocksPerChord == 3 * blocksPerChord / 4)
+        {
+            for (int i = 0; i < numVoices; ++i)
+            {
+                const int note { 24 + (i * 7 + chord) % 96 };
+                midi.addEvent(b % blocksPerChord == 0 ? juce::MidiMessage::noteOn(1, note, 0.8f)
+                                                      : juce::MidiMessage::noteOff(1, note), 0);
+            }
+        }
+
+        buffer.clear();
+        const double start { juce::Time::getMillisecondCounterHiRes() };
+        synth.renderNextBlock(buffer, midi, 0, blockSize);
+        seconds += 0.001 * (juce::Time::getMillisecondCounterHiRes() - start);
+    }
+
+    return seconds / (numBlocks * blockSize / SampleRate);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const int numVoices { argc > 1 ? std::atoi(argv[1]) : 64 };
+    const int blockSize { argc > 2 ? std::atoi(argv[2]) : 512 };
+    const unsigned int unisonVoices { argc > 3 ? static_cast<unsigned int>(std::atoi(argv[3])) : 4u };
+    const int maxCores { std::min(juce::SystemStats::getNumCpus(), DSP::ParallelSynthesiser::MaxWorkers + 1) };
+
+    std::printf("%d voices, %u unison voices, %d sample blocks at %.0f Hz, %d cores available\n",
+                numVoices, unisonVoices, blockSize, SampleRate, juce::SystemStats::getNumCpus());
+
+    double serial { 0.0 };
+    for (int cores = 1; cores <= maxCores; ++cores)
+    {
+        const double share { run(cores - 1, numVoices, blockSize, unisonVoices) };
+        if (cores == 1)
+            serial = share;
+
+        std::printf("%2d cores: %6.2f%% of real time, %.2fx\n", cores, 100.0 * share, serial / share);
+    }
+
+    return 0;
+}
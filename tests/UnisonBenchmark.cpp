@@ -0,0 +1,98 @@
+#include "UnisonOscillator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+// Renders 8 synth voices with 8 unison copies each and checks that they fit in a fixed share of one core
+// The pitch of every voice is updated once per block, as the synth does for its pitch modulation
+
+namespace
+{
+
+constexpr double SampleRate { 48000.0 };
+constexpr unsigned int BlockSize { 64 };
+constexpr unsigned int NumVoices { 8 };
+constexpr unsigned int NumUnisonVoices { 8 };
+constexpr double DurationSeconds { 10.0 };
+constexpr int NumRuns { 5 };
+
+// Share of one core the bank may take, several times the measured cost to leave room for slow machines
+constexpr double MaxCoreShare { 0.05 };
+
+}
+
+int main()
+{
+    std::unique_ptr<DSP::UnisonOscillator> oscillators[NumVoices];
+    for (unsigned int v = 0; v < NumVoices; ++v)
+    {
+        oscillators[v] = std::make_unique<DSP::UnisonOscillator>();
+        oscillators[v]->prepare(SampleRate);
+        oscillators[v]->setNumVoices(NumUnisonVoices);
+        oscillators[v]->setDetune(25.f);
+        oscillators[v]->setSpread(0.8f);
+    }
+
+    alignas(16) float left[BlockSize];
+    alignas(16) float right[BlockSize];
+    alignas(16) float mixLeft[BlockSize];
+    alignas(16) float mixRight[BlockSize];
+
+    const unsigned int numBlocks { static_cast<unsigned int>(DurationSeconds * SampleRate) / BlockSize };
+
+    // Best of a few runs, the others are mostly scheduler noise
+    double bestSeconds { 1e9 };
+    float checksum { 0.f };
+    for (int run = 0; run < NumRuns; ++run)
+    {
+        const auto start { std::chrono::steady_clock::now() };
+
+        for (unsigned int b = 0; b < numBlocks; ++b)
+        {
+            std::fill(mixLeft, mixLeft + BlockSize, 0.f);
+            std::fill(mixRight, mixRight + BlockSize, 0.f);
+
+            for (unsigned int v = 0; v < NumVoices; ++v)
+            {
+                // A slow vibrato around a chord spread over four octaves
+                const float vibrato { 1.f + 0.003f * std::sin(0.01f * static_cast<float>(b + 13 * v)) };
+                oscillators[v]->setFrequency(55.f * std::exp2(0.5f * static_cast<float>(v)) * vibrato);
+                oscillators[v]->process(left, right, BlockSize);
+
+                for (unsigned int n = 0; n < BlockSize; ++n)
+                {
+                    mixLeft[n] += left[n];
+                    mixRight[n] += right[n];
+                }
+            }
+
+            checksum += mixLeft[0] + mixRight[BlockSize - 1];
+        }
+
+        const std::chrono::duration<double> elapsed { std::chrono::steady_clock::now() - start };
+        bestSeconds = std::min(bestSeconds, elapsed.count());
+    }
+
+    const double coreShare { bestSeconds / (static_cast<double>(numBlocks * BlockSize) / SampleRate) };
+
+    // Keeps the rendering from being optimised away
+    if (!std::isfinite(checksum))
+    {
+        std::printf("[FAIL]   output is not finite\n");
+        return 1;
+    }
+
+#if defined(NDEBUG)
+    const bool passed { coreShare <= MaxCoreShare };
+    std::printf("%-8s %u voices x %u unison  %.2f%% of one core, limit %.2f%%\n", passed ? "[PASS]" : "[FAIL]",
+                NumVoices, NumUnisonVoices, 100.0 * coreShare, 100.0 * MaxCoreShare);
+    return passed ? 0 : 1;
+#else
+    std::printf("[SKIP]   %u voices x %u unison  %.2f%% of one core, the %.2f%% limit is only enforced in optimised builds\n",
+                NumVoices, NumUnisonVoices, 100.0 * coreShare, 100.0 * MaxCoreShare);
+    return 0;
+#endif
+}